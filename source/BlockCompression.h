@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "DataTypes.h"
+
+//Decoders of the 4x4 blocks of bc1, bc3 and bc5 to packed rgba8 texels (r | g << 8 | b << 16 | a << 24), the texels are row after row.
+//They follow the D3D10 block compression formats, Texture decodes a block when one of its texels is fetched
+namespace dae
+{
+	//Expands a 5:6:5 color to 8 bits per channel, the top bits are repeated in the bottom ones so 0 and the maximum stay exact
+	inline void UnpackColor565(uint32_t color, uint32_t channels[3])
+	{
+		const uint32_t r{ (color >> 11) & 0x1f };
+		const uint32_t g{ (color >> 5) & 0x3f };
+		const uint32_t b{ color & 0x1f };
+		channels[0] = r << 3 | r >> 2;
+		channels[1] = g << 2 | g >> 4;
+		channels[2] = b << 3 | b >> 2;
+	}
+
+	//bc1 color block: 2 endpoints and a 2 bit index per texel, opaqueOnly is set for the color part of a bc3 block
+	inline void DecodeColorBlock(const uint8_t* pBlock, bool opaqueOnly, uint32_t texels[16])
+	{
+		const uint32_t color0{ pBlock[0] | static_cast<uint32_t>(pBlock[1]) << 8 };
+		const uint32_t color1{ pBlock[2] | static_cast<uint32_t>(pBlock[3]) << 8 };
+
+		uint32_t endpoints[2][3]{};
+		UnpackColor565(color0, endpoints[0]);
+		UnpackColor565(color1, endpoints[1]);
+
+		//color0 <= color1 switches bc1 to 3 colors and transparent black
+		const bool hasFourColors{ opaqueOnly || color0 > color1 };
+
+		uint32_t palette[4]{};
+		for (int channel{}; channel < 3; ++channel)
+		{
+			const uint32_t value0{ endpoints[0][channel] };
+			const uint32_t value1{ endpoints[1][channel] };
+			const int shift{ 8 * channel };
+
+			palette[0] |= value0 << shift;
+			palette[1] |= value1 << shift;
+			if (hasFourColors)
+			{
+				palette[2] |= (2 * value0 + value1 + 1) / 3 << shift;
+				palette[3] |= (value0 + 2 * value1 + 1) / 3 << shift;
+			}
+			else
+			{
+				palette[2] |= (value0 + value1 + 1) / 2 << shift;
+			}
+		}
+
+		palette[0] |= 0xff000000;
+		palette[1] |= 0xff000000;
+		palette[2] |= 0xff000000;
+		if (hasFourColors)
+		{
+			palette[3] |= 0xff000000;
+		}
+
+		const uint32_t indices{ pBlock[4] | pBlock[5] << 8 | pBlock[6] << 16 | static_cast<uint32_t>(pBlock[7]) << 24 };
+		for (int index{}; index < 16; ++index)
+		{
+			texels[index] = palette[(indices >> (2 * index)) & 0x3];
+		}
+	}
+
+	//bc4 channel block (alpha of bc3, red and green of bc5): 2 endpoints and a 3 bit index per texel
+	inline void DecodeChannelBlock(const uint8_t* pBlock, uint8_t values[16])
+	{
+		const uint32_t value0{ pBlock[0] };
+		const uint32_t value1{ pBlock[1] };
+
+		//value0 > value1 interpolates 6 values, otherwise 4 plus 0 and 255
+		uint8_t palette[8]{ static_cast<uint8_t>(value0), static_cast<uint8_t>(value1) };
+		if (value0 > value1)
+		{
+			for (uint32_t step{ 1 }; step < 7; ++step)
+			{
+				palette[step + 1] = static_cast<uint8_t>(((7 - step) * value0 + step * value1 + 3) / 7);
+			}
+		}
+		else
+		{
+			for (uint32_t step{ 1 }; step < 5; ++step)
+			{
+				palette[step + 1] = static_cast<uint8_t>(((5 - step) * value0 + step * value1 + 2) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices{};
+		for (int byte{}; byte < 6; ++byte)
+		{
+			indices |= static_cast<uint64_t>(pBlock[2 + byte]) << (8 * byte);
+		}
+
+		for (int index{}; index < 16; ++index)
+		{
+			values[index] = palette[(indices >> (3 * index)) & 0x7];
+		}
+	}
+
+	//Decodes a 4x4 block to packed rgba8 texels, row after row
+	inline void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint32_t texels[16])
+	{
+		switch (format)
+		{
+		case TextureFormat::bc1:
+			DecodeColorBlock(pBlock, false, texels);
+			break;
+
+		case TextureFormat::bc3:
+		{
+			uint8_t alphas[16]{};
+			DecodeChannelBlock(pBlock, alphas);
+			DecodeColorBlock(pBlock + 8, true, texels);
+
+			for (int index{}; index < 16; ++index)
+			{
+				texels[index] = (texels[index] & 0x00ffffff) | static_cast<uint32_t>(alphas[index]) << 24;
+			}
+			break;
+		}
+
+		case TextureFormat::bc5:
+		{
+			uint8_t xs[16]{};
+			uint8_t ys[16]{};
+			DecodeChannelBlock(pBlock, xs);
+			DecodeChannelBlock(pBlock + 8, ys);
+
+			//a unit normal pointing out of the surface, so z follows from x and y
+			constexpr float normalize{ 2.f / 255.f };
+			for (int index{}; index < 16; ++index)
+			{
+				const float x{ xs[index] * normalize - 1.f };
+				const float y{ ys[index] * normalize - 1.f };
+				const float z{ std::sqrt(std::max(1.f - x * x - y * y, 0.f)) };
+				const uint32_t zValue{ static_cast<uint32_t>((z * 0.5f + 0.5f) * 255.f + 0.5f) };
+
+				texels[index] = xs[index] | ys[index] << 8 | zValue << 16 | 0xff000000;
+			}
+			break;
+		}
+
+		case TextureFormat::rgba8:
+			break;
+		}
+	}
+}
@@ -24,6 +24,121 @@ namespace dae
 		Vector3 viewDirection{};
 	};
 
+	//Positions, normals and tangents of the mesh vertices as a structure of arrays, the input of the batched vertex transform
+	struct VertexStreams
+	{
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+
+		size_t Size() const
+		{
+			return positionX.size();
+		}
+
+		void Fill(const std::vector<Vertex>& vertices)
+		{
+			for (std::vector<float>* pStream : { &positionX, &positionY, &positionZ, &normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ })
+			{
+				pStream->resize(vertices.size());
+			}
+
+			for (size_t index{}; index < vertices.size(); ++index)
+			{
+				const Vertex& vertex{ vertices[index] };
+				positionX[index] = vertex.position.x;
+				positionY[index] = vertex.position.y;
+				positionZ[index] = vertex.position.z;
+				normalX[index] = vertex.normal.x;
+				normalY[index] = vertex.normal.y;
+				normalZ[index] = vertex.normal.z;
+				tangentX[index] = vertex.tangent.x;
+				tangentY[index] = vertex.tangent.y;
+				tangentZ[index] = vertex.tangent.z;
+			}
+		}
+
+		VertexStreamsIn GetStreams(size_t first) const
+		{
+			return
+			{
+				positionX.data() + first, positionY.data() + first, positionZ.data() + first,
+				normalX.data() + first, normalY.data() + first, normalZ.data() + first,
+				tangentX.data() + first, tangentY.data() + first, tangentZ.data() + first
+			};
+		}
+	};
+
+	//Output of the vertex stage as a structure of arrays, one entry per vertex of the mesh followed by the vertices the clipper added
+	//the position is already in screen space: x and y in pixels, z the ndc depth and w holding 1 / w
+	struct TransformedVertices
+	{
+		std::vector<float> x{};
+		std::vector<float> y{};
+		std::vector<float> z{};
+		std::vector<float> w{};
+		std::vector<float> u{};
+		std::vector<float> v{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+		std::vector<float> viewDirectionX{};
+		std::vector<float> viewDirectionY{};
+		std::vector<float> viewDirectionZ{};
+
+		//the planes of the view frustum and of the guard band the clip space position is outside of, one bit per plane
+		std::vector<uint8_t> frustumOutcodes{};
+		std::vector<uint8_t> clipOutcodes{};
+
+		size_t Size() const
+		{
+			return x.size();
+		}
+
+		//shrinking keeps the capacity, so after the first frame this never allocates
+		void Resize(size_t size)
+		{
+			for (std::vector<float>* pStream : { &x, &y, &z, &w, &u, &v, &normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ, &viewDirectionX, &viewDirectionY, &viewDirectionZ })
+			{
+				pStream->resize(size);
+			}
+			frustumOutcodes.resize(size);
+			clipOutcodes.resize(size);
+		}
+
+		//the clip space position goes in x, y, z and w, the vertex stage maps it to the screen afterwards
+		VertexStreamsOut GetStreams(size_t first)
+		{
+			return
+			{
+				x.data() + first, y.data() + first, z.data() + first, w.data() + first,
+				normalX.data() + first, normalY.data() + first, normalZ.data() + first,
+				tangentX.data() + first, tangentY.data() + first, tangentZ.data() + first,
+				viewDirectionX.data() + first, viewDirectionY.data() + first, viewDirectionZ.data() + first
+			};
+		}
+
+		Vertex_Out GetVertex(uint32_t index) const
+		{
+			Vertex_Out vertex{};
+			vertex.position = { x[index], y[index], z[index], w[index] };
+			vertex.uv = { u[index], v[index] };
+			vertex.normal = { normalX[index], normalY[index], normalZ[index] };
+			vertex.tangent = { tangentX[index], tangentY[index], tangentZ[index] };
+			vertex.viewDirection = { viewDirectionX[index], viewDirectionY[index], viewDirectionZ[index] };
+			return vertex;
+		}
+	};
+
 	enum class PrimitiveTopology
 	{
 		TriangeList,
@@ -37,6 +152,57 @@ namespace dae
 		NoCulling
 	};
 
+	enum class FilterMode
+	{
+		point, //nearest texel of the full resolution texture
+		bilinear, //4 texels of the closest mip level
+		trilinear //bilinear in the two closest mip levels, blended
+	};
+
+	//How the texels of a mip level are ordered in memory
+	enum class TextureLayout
+	{
+		linear, //row after row
+		tiled4x4, //4x4 blocks of 64 bytes, one cache line each
+		tiled8x8, //8x8 blocks of 256 bytes
+		morton //Z-order inside square power of two blocks, neighbours in x and y stay close at every scale
+	};
+
+	enum class TextureFormat
+	{
+		rgba8, //4 bytes per texel
+		bc1, //8 bytes per 4x4 block: rgb, 1 bit alpha
+		bc3, //16 bytes per 4x4 block: bc1 rgb + interpolated alpha
+		bc5 //16 bytes per 4x4 block: 2 interpolated channels, the z of a normal is rebuilt in blue
+	};
+
+	class Texture;
+
+	//What happens with a fragment that passes the depth test
+	enum class BlendMode
+	{
+		opaque, //passes when it is not farther than the depth buffer
+		alphaBlend //passes when it is closer, blends over the color buffer with the alpha of the material
+	};
+
+	//The shading function of a material, every model is its own functor in the renderer so the raster loops call it without dispatch
+	enum class ShadingModel
+	{
+		phong, //lambert diffuse + phong specular with a normal map
+		unlit //the diffuse map as it is
+	};
+
+	//How the triangles of a mesh are shaded, the textures are owned by whoever loaded them
+	struct Material
+	{
+		ShadingModel shadingModel{ ShadingModel::phong };
+		BlendMode blendMode{ BlendMode::opaque };
+		bool writesDepth{ true };
+
+		const Texture* pDiffuseMap{}; //phong: diffuse rgb + glossiness in alpha, unlit: the color and its alpha
+		const Texture* pNormalMap{}; //phong: normal xy + specular intensity in blue
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
@@ -44,8 +210,35 @@ namespace dae
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleStrip };
 		CullMode cullMode{};
 
-		std::vector<Vertex_Out> vertices_out{};
+		VertexStreams vertexStreams{};
+		TransformedVertices vertices_out{};
+		std::vector<uint32_t> indices_out{}; //triangle list of the clipped triangles, indexes vertices_out
 		Matrix worldMatrix{};
 		float rotationAngle{};
+		Material material{};
+
+		//builds the streams of the vertex stage once, the uvs don't depend on the transform so they are only written here
+		void InitializeStreams()
+		{
+			vertexStreams.Fill(vertices);
+			vertices_out.Resize(vertices.size());
+
+			for (size_t index{}; index < vertices.size(); ++index)
+			{
+				vertices_out.u[index] = vertices[index].uv.x;
+				vertices_out.v[index] = vertices[index].uv.y;
+			}
+		}
+	};
+
+	//Where the camera is and how far the meshes are turned at a moment of a scripted run, the angles are in degrees
+	struct CameraKeyframe
+	{
+		float time{}; //in seconds
+		Vector3 origin{};
+		float yaw{};
+		float pitch{};
+		float fovAngle{ 45.f };
+		float sceneRotation{};
 	};
 }
\ No newline at end of file
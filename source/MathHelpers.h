@@ -1,5 +1,11 @@
 #pragma once
 #include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <vector>
+#include <immintrin.h>
 
 namespace dae
 {
@@ -64,4 +70,173 @@ namespace dae
 
 		return (value - low) / (high - low);
 	}
+
+	/* --- FAST MATH --- */
+	//The exp2 and log2 approximations only use multiplies, adds, selects and integer bit operations, loops over them vectorize
+	//as long as the compiler may assume floats don't trap (/fp:fast, -fno-trapping-math).
+	//The error bounds are measured over the whole float range the function accepts
+	enum class MathAccuracy
+	{
+		exact, //the standard library
+		fast, //polynomials, relative error below 1e-5
+		approximate //parabolas and the reciprocal square root estimate of the cpu, relative error below 1e-2 except for Log2, which is off by less than 8e-3 absolute
+	};
+
+	//log2(x) for x > 0
+	template<MathAccuracy Accuracy>
+	inline float Log2(float x)
+	{
+		if constexpr (Accuracy == MathAccuracy::exact)
+		{
+			return std::log2(x);
+		}
+		else if constexpr (Accuracy == MathAccuracy::fast)
+		{
+			//split x in 2^exponent * mantissa with the mantissa in [sqrt(0.5), sqrt(2)), so t stays small
+			const int32_t bits{ std::bit_cast<int32_t>(x) };
+			const int32_t offset{ bits - 0x3f3504f3 };
+			const int32_t exponent{ offset >> 23 };
+			const float mantissa{ std::bit_cast<float>(bits - (exponent << 23)) };
+
+			//log2(m) = 2 / ln(2) * atanh(t) with t = (m - 1) / (m + 1)
+			const float t{ (mantissa - 1.f) / (mantissa + 1.f) };
+			const float t2{ t * t };
+			const float series{ t * (2.885390082f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f))) };
+			return static_cast<float>(exponent) + series;
+		}
+		else
+		{
+			//the exponent is the integer part, a parabola through the mantissa in [1, 2) is the fraction.
+			//It goes through (1, 0) and (2, 1), so powers of 2 are exact and the result is continuous where the exponent changes
+			const int32_t bits{ std::bit_cast<int32_t>(x) };
+			const float mantissa{ std::bit_cast<float>((bits & 0x007fffff) | 0x3f800000) };
+			const float exponent{ static_cast<float>((bits >> 23) - 127) };
+			return exponent + (mantissa - 1.f) * (-0.34655539f * mantissa + 1.69311077f);
+		}
+	}
+
+	struct ExponentSplit
+	{
+		float power{}; //2^round(x)
+		float fraction{}; //x - round(x)
+	};
+
+	//Splits x, clamped to the range of normal floats, in its nearest integer and the rest.
+	//Adding 1.5 * 2^23 pushes the fraction out of the mantissa, which rounds without a call to floor and leaves the integer in the low bits
+	inline ExponentSplit SplitExponent(float x)
+	{
+		constexpr float roundingOffset{ 12582912.f };
+
+		const float clamped{ std::min(std::max(x, -126.f), 127.f) };
+		const float shifted{ clamped + roundingOffset };
+		const int32_t exponent{ std::bit_cast<int32_t>(shifted) - std::bit_cast<int32_t>(roundingOffset) };
+		return { std::bit_cast<float>((exponent + 127) << 23), clamped - (shifted - roundingOffset) };
+	}
+
+	//2^x, x is clamped to the range of normal floats
+	template<MathAccuracy Accuracy>
+	inline float Exp2(float x)
+	{
+		if constexpr (Accuracy == MathAccuracy::exact)
+		{
+			return std::exp2(x);
+		}
+		else if constexpr (Accuracy == MathAccuracy::fast)
+		{
+			//2^x = 2^round(x) * 2^f with f in [-0.5, 0.5], 2^f is the taylor series of e^(f * ln(2))
+			const ExponentSplit split{ SplitExponent(x) };
+			const float f{ split.fraction };
+			const float series{ 1.f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * (0.00133335581f + f * 0.000154035304f))))) };
+			return split.power * series;
+		}
+		else
+		{
+			//a parabola fitted to 2^f over [-0.5, 0.5]
+			const ExponentSplit split{ SplitExponent(x) };
+			const float f{ split.fraction };
+			return split.power * (1.f + f * (0.7027f + f * 0.2393f));
+		}
+	}
+
+	//base^exponent for base >= 0, pow(0, 0) is 1 like std::pow. The error of the log2 is scaled by the exponent,
+	//with approximate accuracy and an exponent up to 32 the absolute error for a base in [0, 1] stays below 0.04
+	template<MathAccuracy Accuracy>
+	inline float Pow(float base, float exponent)
+	{
+		if constexpr (Accuracy == MathAccuracy::exact)
+		{
+			return std::pow(base, exponent);
+		}
+		else
+		{
+			const float result{ Exp2<Accuracy>(exponent * Log2<Accuracy>(std::max(base, FLT_MIN))) };
+			const float resultOfZero{ exponent == 0.f ? 1.f : 0.f };
+			return base > 0.f ? result : resultOfZero;
+		}
+	}
+
+	//1 / sqrt(x) for x > 0
+	template<MathAccuracy Accuracy>
+	inline float InverseSqrt(float x)
+	{
+		if constexpr (Accuracy == MathAccuracy::exact)
+		{
+			return 1.f / std::sqrt(x);
+		}
+		else
+		{
+			//the 12 bit estimate of the cpu, a newton step doubles the amount of correct bits
+			const float estimate{ _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x))) };
+			if constexpr (Accuracy == MathAccuracy::fast)
+				return estimate * (1.5f - 0.5f * x * estimate * estimate);
+			else
+				return estimate;
+		}
+	}
+
+	//pow(cosine, shininess * glossiness) for cosine and glossiness in [0, 1], bilinearly interpolated between precomputed entries.
+	//There is a row for every value of an 8 bit glossiness channel, so unfiltered glossiness is only interpolated along the cosine.
+	//With a shininess of 25 the absolute error stays below 4e-3 for 8 bit glossiness and 1e-2 for filtered glossiness, as long as the cosine is above 1/16
+	class SpecularLookupTable final
+	{
+	public:
+		explicit SpecularLookupTable(float shininess)
+			: m_Entries((m_GlossinessResolution + 1) * m_RowSize)
+		{
+			for (int glossinessIndex{}; glossinessIndex <= m_GlossinessResolution; ++glossinessIndex)
+			{
+				const float exponent{ shininess * glossinessIndex / m_GlossinessResolution };
+				for (int cosineIndex{}; cosineIndex <= m_CosineResolution; ++cosineIndex)
+				{
+					m_Entries[glossinessIndex * m_RowSize + cosineIndex] = std::pow(static_cast<float>(cosineIndex) / m_CosineResolution, exponent);
+				}
+			}
+		}
+
+		float Lookup(float cosine, float glossiness) const
+		{
+			//clamped in this order so NaN becomes 0 instead of an index outside the table
+			const float u{ std::max(0.f, std::min(cosine, 1.f)) * m_CosineResolution };
+			const float v{ std::max(0.f, std::min(glossiness, 1.f)) * m_GlossinessResolution };
+
+			//the last entry is only used with a fraction of 0
+			const int cosineIndex{ std::min(static_cast<int>(u), m_CosineResolution - 1) };
+			const int glossinessIndex{ std::min(static_cast<int>(v), m_GlossinessResolution - 1) };
+			const float fractionU{ u - cosineIndex };
+			const float fractionV{ v - glossinessIndex };
+
+			const float* pRow0{ m_Entries.data() + glossinessIndex * m_RowSize + cosineIndex };
+			const float* pRow1{ pRow0 + m_RowSize };
+			const float top{ Lerpf(pRow0[0], pRow0[1], fractionU) };
+			const float bottom{ Lerpf(pRow1[0], pRow1[1], fractionU) };
+			return Lerpf(top, bottom, fractionV);
+		}
+
+	private:
+		static constexpr int m_CosineResolution{ 256 };
+		static constexpr int m_GlossinessResolution{ 255 };
+		static constexpr int m_RowSize{ m_CosineResolution + 1 };
+
+		std::vector<float> m_Entries{};
+	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include "MathHelpers.h"
+#include "Simd.h"
 #include <cmath>
 
 namespace dae {
@@ -70,6 +71,302 @@ namespace dae {
 		};
 	}
 
+	//Broadcasts every element of the matrix, columns[c][r] holds data[r][c] so one column produces one output component
+	TARGET_SSE41 static void BroadcastColumnsSSE41(const Matrix& m, __m128 columns[4][4])
+	{
+		for (int column{}; column < 4; ++column)
+		{
+			for (int row{}; row < 4; ++row)
+			{
+				columns[column][row] = _mm_set1_ps(m[row][column]);
+			}
+		}
+	}
+
+	//Same order of operations as TransformPoint and TransformVector, so the results match them exactly
+	TARGET_SSE41 static inline __m128 TransformPointComponentSSE41(const __m128 column[4], __m128 x, __m128 y, __m128 z)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(column[0], x), _mm_mul_ps(column[1], y)), _mm_mul_ps(column[2], z)), column[3]);
+	}
+
+	TARGET_SSE41 static inline __m128 TransformVectorComponentSSE41(const __m128 column[4], __m128 x, __m128 y, __m128 z)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(column[0], x), _mm_mul_ps(column[1], y)), _mm_mul_ps(column[2], z));
+	}
+
+	TARGET_AVX2 static void BroadcastColumnsAVX2(const Matrix& m, __m256 columns[4][4])
+	{
+		for (int column{}; column < 4; ++column)
+		{
+			for (int row{}; row < 4; ++row)
+			{
+				columns[column][row] = _mm256_set1_ps(m[row][column]);
+			}
+		}
+	}
+
+	TARGET_AVX2 static inline __m256 TransformPointComponentAVX2(const __m256 column[4], __m256 x, __m256 y, __m256 z)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(column[0], x), _mm256_mul_ps(column[1], y)), _mm256_mul_ps(column[2], z)), column[3]);
+	}
+
+	TARGET_AVX2 static inline __m256 TransformVectorComponentAVX2(const __m256 column[4], __m256 x, __m256 y, __m256 z)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(column[0], x), _mm256_mul_ps(column[1], y)), _mm256_mul_ps(column[2], z));
+	}
+
+	//The kernels only process whole registers and return how many elements they did, the caller finishes the rest
+	TARGET_SSE41 static size_t TransformPointsSSE41(const Matrix& m, const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs, float* pOutWs)
+	{
+		__m128 columns[4][4];
+		BroadcastColumnsSSE41(m, columns);
+
+		size_t index{};
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 x{ _mm_loadu_ps(pXs + index) };
+			const __m128 y{ _mm_loadu_ps(pYs + index) };
+			const __m128 z{ _mm_loadu_ps(pZs + index) };
+
+			_mm_storeu_ps(pOutXs + index, TransformPointComponentSSE41(columns[0], x, y, z));
+			_mm_storeu_ps(pOutYs + index, TransformPointComponentSSE41(columns[1], x, y, z));
+			_mm_storeu_ps(pOutZs + index, TransformPointComponentSSE41(columns[2], x, y, z));
+			_mm_storeu_ps(pOutWs + index, TransformPointComponentSSE41(columns[3], x, y, z));
+		}
+		return index;
+	}
+
+	TARGET_AVX2 static size_t TransformPointsAVX2(const Matrix& m, const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs, float* pOutWs)
+	{
+		__m256 columns[4][4];
+		BroadcastColumnsAVX2(m, columns);
+
+		size_t index{};
+		for (; index + 8 <= count; index += 8)
+		{
+			const __m256 x{ _mm256_loadu_ps(pXs + index) };
+			const __m256 y{ _mm256_loadu_ps(pYs + index) };
+			const __m256 z{ _mm256_loadu_ps(pZs + index) };
+
+			_mm256_storeu_ps(pOutXs + index, TransformPointComponentAVX2(columns[0], x, y, z));
+			_mm256_storeu_ps(pOutYs + index, TransformPointComponentAVX2(columns[1], x, y, z));
+			_mm256_storeu_ps(pOutZs + index, TransformPointComponentAVX2(columns[2], x, y, z));
+			_mm256_storeu_ps(pOutWs + index, TransformPointComponentAVX2(columns[3], x, y, z));
+		}
+		return index;
+	}
+
+	TARGET_SSE41 static size_t TransformVectorsSSE41(const Matrix& m, const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs)
+	{
+		__m128 columns[4][4];
+		BroadcastColumnsSSE41(m, columns);
+
+		size_t index{};
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 x{ _mm_loadu_ps(pXs + index) };
+			const __m128 y{ _mm_loadu_ps(pYs + index) };
+			const __m128 z{ _mm_loadu_ps(pZs + index) };
+
+			_mm_storeu_ps(pOutXs + index, TransformVectorComponentSSE41(columns[0], x, y, z));
+			_mm_storeu_ps(pOutYs + index, TransformVectorComponentSSE41(columns[1], x, y, z));
+			_mm_storeu_ps(pOutZs + index, TransformVectorComponentSSE41(columns[2], x, y, z));
+		}
+		return index;
+	}
+
+	TARGET_AVX2 static size_t TransformVectorsAVX2(const Matrix& m, const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs)
+	{
+		__m256 columns[4][4];
+		BroadcastColumnsAVX2(m, columns);
+
+		size_t index{};
+		for (; index + 8 <= count; index += 8)
+		{
+			const __m256 x{ _mm256_loadu_ps(pXs + index) };
+			const __m256 y{ _mm256_loadu_ps(pYs + index) };
+			const __m256 z{ _mm256_loadu_ps(pZs + index) };
+
+			_mm256_storeu_ps(pOutXs + index, TransformVectorComponentAVX2(columns[0], x, y, z));
+			_mm256_storeu_ps(pOutYs + index, TransformVectorComponentAVX2(columns[1], x, y, z));
+			_mm256_storeu_ps(pOutZs + index, TransformVectorComponentAVX2(columns[2], x, y, z));
+		}
+		return index;
+	}
+
+	TARGET_SSE41 static size_t TransformVerticesSSE41(const Matrix& worldViewProjection, const Matrix& world, const Vector3& viewOrigin, const VertexStreamsIn& in, size_t count, const VertexStreamsOut& out)
+	{
+		__m128 projectionColumns[4][4];
+		__m128 worldColumns[4][4];
+		BroadcastColumnsSSE41(worldViewProjection, projectionColumns);
+		BroadcastColumnsSSE41(world, worldColumns);
+
+		const __m128 originX{ _mm_set1_ps(viewOrigin.x) };
+		const __m128 originY{ _mm_set1_ps(viewOrigin.y) };
+		const __m128 originZ{ _mm_set1_ps(viewOrigin.z) };
+
+		size_t index{};
+		for (; index + 4 <= count; index += 4)
+		{
+			const __m128 positionX{ _mm_loadu_ps(in.pPositionX + index) };
+			const __m128 positionY{ _mm_loadu_ps(in.pPositionY + index) };
+			const __m128 positionZ{ _mm_loadu_ps(in.pPositionZ + index) };
+
+			_mm_storeu_ps(out.pPositionX + index, TransformPointComponentSSE41(projectionColumns[0], positionX, positionY, positionZ));
+			_mm_storeu_ps(out.pPositionY + index, TransformPointComponentSSE41(projectionColumns[1], positionX, positionY, positionZ));
+			_mm_storeu_ps(out.pPositionZ + index, TransformPointComponentSSE41(projectionColumns[2], positionX, positionY, positionZ));
+			_mm_storeu_ps(out.pPositionW + index, TransformPointComponentSSE41(projectionColumns[3], positionX, positionY, positionZ));
+
+			_mm_storeu_ps(out.pViewDirectionX + index, _mm_sub_ps(originX, TransformPointComponentSSE41(worldColumns[0], positionX, positionY, positionZ)));
+			_mm_storeu_ps(out.pViewDirectionY + index, _mm_sub_ps(originY, TransformPointComponentSSE41(worldColumns[1], positionX, positionY, positionZ)));
+			_mm_storeu_ps(out.pViewDirectionZ + index, _mm_sub_ps(originZ, TransformPointComponentSSE41(worldColumns[2], positionX, positionY, positionZ)));
+
+			const __m128 normalX{ _mm_loadu_ps(in.pNormalX + index) };
+			const __m128 normalY{ _mm_loadu_ps(in.pNormalY + index) };
+			const __m128 normalZ{ _mm_loadu_ps(in.pNormalZ + index) };
+
+			_mm_storeu_ps(out.pNormalX + index, TransformVectorComponentSSE41(worldColumns[0], normalX, normalY, normalZ));
+			_mm_storeu_ps(out.pNormalY + index, TransformVectorComponentSSE41(worldColumns[1], normalX, normalY, normalZ));
+			_mm_storeu_ps(out.pNormalZ + index, TransformVectorComponentSSE41(worldColumns[2], normalX, normalY, normalZ));
+
+			const __m128 tangentX{ _mm_loadu_ps(in.pTangentX + index) };
+			const __m128 tangentY{ _mm_loadu_ps(in.pTangentY + index) };
+			const __m128 tangentZ{ _mm_loadu_ps(in.pTangentZ + index) };
+
+			_mm_storeu_ps(out.pTangentX + index, TransformVectorComponentSSE41(worldColumns[0], tangentX, tangentY, tangentZ));
+			_mm_storeu_ps(out.pTangentY + index, TransformVectorComponentSSE41(worldColumns[1], tangentX, tangentY, tangentZ));
+			_mm_storeu_ps(out.pTangentZ + index, TransformVectorComponentSSE41(worldColumns[2], tangentX, tangentY, tangentZ));
+		}
+		return index;
+	}
+
+	TARGET_AVX2 static size_t TransformVerticesAVX2(const Matrix& worldViewProjection, const Matrix& world, const Vector3& viewOrigin, const VertexStreamsIn& in, size_t count, const VertexStreamsOut& out)
+	{
+		__m256 projectionColumns[4][4];
+		__m256 worldColumns[4][4];
+		BroadcastColumnsAVX2(worldViewProjection, projectionColumns);
+		BroadcastColumnsAVX2(world, worldColumns);
+
+		const __m256 originX{ _mm256_set1_ps(viewOrigin.x) };
+		const __m256 originY{ _mm256_set1_ps(viewOrigin.y) };
+		const __m256 originZ{ _mm256_set1_ps(viewOrigin.z) };
+
+		size_t index{};
+		for (; index + 8 <= count; index += 8)
+		{
+			const __m256 positionX{ _mm256_loadu_ps(in.pPositionX + index) };
+			const __m256 positionY{ _mm256_loadu_ps(in.pPositionY + index) };
+			const __m256 positionZ{ _mm256_loadu_ps(in.pPositionZ + index) };
+
+			_mm256_storeu_ps(out.pPositionX + index, TransformPointComponentAVX2(projectionColumns[0], positionX, positionY, positionZ));
+			_mm256_storeu_ps(out.pPositionY + index, TransformPointComponentAVX2(projectionColumns[1], positionX, positionY, positionZ));
+			_mm256_storeu_ps(out.pPositionZ + index, TransformPointComponentAVX2(projectionColumns[2], positionX, positionY, positionZ));
+			_mm256_storeu_ps(out.pPositionW + index, TransformPointComponentAVX2(projectionColumns[3], positionX, positionY, positionZ));
+
+			_mm256_storeu_ps(out.pViewDirectionX + index, _mm256_sub_ps(originX, TransformPointComponentAVX2(worldColumns[0], positionX, positionY, positionZ)));
+			_mm256_storeu_ps(out.pViewDirectionY + index, _mm256_sub_ps(originY, TransformPointComponentAVX2(worldColumns[1], positionX, positionY, positionZ)));
+			_mm256_storeu_ps(out.pViewDirectionZ + index, _mm256_sub_ps(originZ, TransformPointComponentAVX2(worldColumns[2], positionX, positionY, positionZ)));
+
+			const __m256 normalX{ _mm256_loadu_ps(in.pNormalX + index) };
+			const __m256 normalY{ _mm256_loadu_ps(in.pNormalY + index) };
+			const __m256 normalZ{ _mm256_loadu_ps(in.pNormalZ + index) };
+
+			_mm256_storeu_ps(out.pNormalX + index, TransformVectorComponentAVX2(worldColumns[0], normalX, normalY, normalZ));
+			_mm256_storeu_ps(out.pNormalY + index, TransformVectorComponentAVX2(worldColumns[1], normalX, normalY, normalZ));
+			_mm256_storeu_ps(out.pNormalZ + index, TransformVectorComponentAVX2(worldColumns[2], normalX, normalY, normalZ));
+
+			const __m256 tangentX{ _mm256_loadu_ps(in.pTangentX + index) };
+			const __m256 tangentY{ _mm256_loadu_ps(in.pTangentY + index) };
+			const __m256 tangentZ{ _mm256_loadu_ps(in.pTangentZ + index) };
+
+			_mm256_storeu_ps(out.pTangentX + index, TransformVectorComponentAVX2(worldColumns[0], tangentX, tangentY, tangentZ));
+			_mm256_storeu_ps(out.pTangentY + index, TransformVectorComponentAVX2(worldColumns[1], tangentX, tangentY, tangentZ));
+			_mm256_storeu_ps(out.pTangentZ + index, TransformVectorComponentAVX2(worldColumns[2], tangentX, tangentY, tangentZ));
+		}
+		return index;
+	}
+
+	void Matrix::TransformPoints(const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs, float* pOutWs) const
+	{
+		size_t index{};
+		if (GetSimdWidth() == 8)
+		{
+			index = TransformPointsAVX2(*this, pXs, pYs, pZs, count, pOutXs, pOutYs, pOutZs, pOutWs);
+		}
+		else if (GetSimdWidth() == 4)
+		{
+			index = TransformPointsSSE41(*this, pXs, pYs, pZs, count, pOutXs, pOutYs, pOutZs, pOutWs);
+		}
+
+		//the points that don't fill a whole register
+		for (; index < count; ++index)
+		{
+			const Vector4 point{ TransformPoint(pXs[index], pYs[index], pZs[index], 0) };
+			pOutXs[index] = point.x;
+			pOutYs[index] = point.y;
+			pOutZs[index] = point.z;
+			pOutWs[index] = point.w;
+		}
+	}
+
+	void Matrix::TransformVectors(const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs) const
+	{
+		size_t index{};
+		if (GetSimdWidth() == 8)
+		{
+			index = TransformVectorsAVX2(*this, pXs, pYs, pZs, count, pOutXs, pOutYs, pOutZs);
+		}
+		else if (GetSimdWidth() == 4)
+		{
+			index = TransformVectorsSSE41(*this, pXs, pYs, pZs, count, pOutXs, pOutYs, pOutZs);
+		}
+
+		for (; index < count; ++index)
+		{
+			const Vector3 vector{ TransformVector(pXs[index], pYs[index], pZs[index]) };
+			pOutXs[index] = vector.x;
+			pOutYs[index] = vector.y;
+			pOutZs[index] = vector.z;
+		}
+	}
+
+	void Matrix::TransformVertices(const Matrix& worldViewProjection, const Matrix& world, const Vector3& viewOrigin, const VertexStreamsIn& in, size_t count, const VertexStreamsOut& out)
+	{
+		size_t index{};
+		if (GetSimdWidth() == 8)
+		{
+			index = TransformVerticesAVX2(worldViewProjection, world, viewOrigin, in, count, out);
+		}
+		else if (GetSimdWidth() == 4)
+		{
+			index = TransformVerticesSSE41(worldViewProjection, world, viewOrigin, in, count, out);
+		}
+
+		for (; index < count; ++index)
+		{
+			const Vector4 position{ worldViewProjection.TransformPoint(in.pPositionX[index], in.pPositionY[index], in.pPositionZ[index], 0) };
+			out.pPositionX[index] = position.x;
+			out.pPositionY[index] = position.y;
+			out.pPositionZ[index] = position.z;
+			out.pPositionW[index] = position.w;
+
+			const Vector3 worldPosition{ world.TransformPoint(in.pPositionX[index], in.pPositionY[index], in.pPositionZ[index]) };
+			out.pViewDirectionX[index] = viewOrigin.x - worldPosition.x;
+			out.pViewDirectionY[index] = viewOrigin.y - worldPosition.y;
+			out.pViewDirectionZ[index] = viewOrigin.z - worldPosition.z;
+
+			const Vector3 normal{ world.TransformVector(in.pNormalX[index], in.pNormalY[index], in.pNormalZ[index]) };
+			out.pNormalX[index] = normal.x;
+			out.pNormalY[index] = normal.y;
+			out.pNormalZ[index] = normal.z;
+
+			const Vector3 tangent{ world.TransformVector(in.pTangentX[index], in.pTangentY[index], in.pTangentZ[index]) };
+			out.pTangentX[index] = tangent.x;
+			out.pTangentY[index] = tangent.y;
+			out.pTangentZ[index] = tangent.z;
+		}
+	}
+
 	const Matrix& Matrix::Transpose()
 	{
 		Matrix result{};
@@ -1,8 +1,41 @@
 #pragma once
 #include "Vector3.h"
 #include "Vector4.h"
+#include <cstddef>
 
 namespace dae {
+	//Structure of arrays input of Matrix::TransformVertices, every pointer points to count floats
+	struct VertexStreamsIn
+	{
+		const float* pPositionX{};
+		const float* pPositionY{};
+		const float* pPositionZ{};
+		const float* pNormalX{};
+		const float* pNormalY{};
+		const float* pNormalZ{};
+		const float* pTangentX{};
+		const float* pTangentY{};
+		const float* pTangentZ{};
+	};
+
+	//Structure of arrays output of Matrix::TransformVertices, every pointer points to room for count floats
+	struct VertexStreamsOut
+	{
+		float* pPositionX{};
+		float* pPositionY{};
+		float* pPositionZ{};
+		float* pPositionW{};
+		float* pNormalX{};
+		float* pNormalY{};
+		float* pNormalZ{};
+		float* pTangentX{};
+		float* pTangentY{};
+		float* pTangentZ{};
+		float* pViewDirectionX{};
+		float* pViewDirectionY{};
+		float* pViewDirectionZ{};
+	};
+
 	struct Matrix
 	{
 		Matrix() = default;
@@ -28,6 +61,13 @@ namespace dae {
 		Vector4 TransformPoint(const Vector4& p) const;
 		Vector4 TransformPoint(float x, float y, float z, float w) const;
 
+		//Batch versions for structure of arrays data, 8 (AVX2) or 4 (SSE4.1) elements per instruction with the same results as the single versions
+		void TransformPoints(const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs, float* pOutWs) const;
+		void TransformVectors(const float* pXs, const float* pYs, const float* pZs, size_t count, float* pOutXs, float* pOutYs, float* pOutZs) const;
+
+		//The whole vertex stage in one pass: clip space position, world normal, world tangent and the direction from the world position to viewOrigin
+		static void TransformVertices(const Matrix& worldViewProjection, const Matrix& world, const Vector3& viewOrigin, const VertexStreamsIn& in, size_t count, const VertexStreamsOut& out);
+
 		const Matrix& Transpose();
 		const Matrix& Inverse();
 
@@ -0,0 +1,111 @@
+#include "MemoryMappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+#if defined(_WIN32)
+	MemoryMappedFile::MemoryMappedFile(const std::string& path)
+	{
+		m_pFileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_pFileHandle == INVALID_HANDLE_VALUE)
+		{
+			m_pFileHandle = nullptr;
+			return;
+		}
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(m_pFileHandle, &size))
+			return;
+
+		m_Size = static_cast<size_t>(size.QuadPart);
+
+		//a mapping of 0 bytes can't be created, an empty file is open without data
+		if (m_Size == 0)
+		{
+			m_IsOpen = true;
+			return;
+		}
+
+		m_pMappingHandle = CreateFileMappingA(m_pFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_pMappingHandle)
+			return;
+
+		m_pData = static_cast<const char*>(MapViewOfFile(m_pMappingHandle, FILE_MAP_READ, 0, 0, 0));
+		m_IsOpen = m_pData != nullptr;
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+		if (m_pMappingHandle)
+			CloseHandle(m_pMappingHandle);
+		if (m_pFileHandle)
+			CloseHandle(m_pFileHandle);
+	}
+#else
+	MemoryMappedFile::MemoryMappedFile(const std::string& path)
+	{
+		const int fileDescriptor{ open(path.c_str(), O_RDONLY) };
+		if (fileDescriptor < 0)
+			return;
+
+		struct stat status{};
+		if (fstat(fileDescriptor, &status) == 0)
+		{
+			m_Size = static_cast<size_t>(status.st_size);
+
+			//a mapping of 0 bytes can't be created, an empty file is open without data
+			if (m_Size == 0)
+			{
+				m_IsOpen = true;
+			}
+			else
+			{
+				void* pMapping{ mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0) };
+				if (pMapping != MAP_FAILED)
+				{
+					//the whole file is read front to back
+					madvise(pMapping, m_Size, MADV_SEQUENTIAL);
+					m_pData = static_cast<const char*>(pMapping);
+					m_IsOpen = true;
+				}
+			}
+		}
+
+		//the mapping keeps the file alive on its own
+		close(fileDescriptor);
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+		if (m_pData)
+			munmap(const_cast<char*>(m_pData), m_Size);
+	}
+#endif
+
+	bool MemoryMappedFile::IsOpen() const
+	{
+		return m_IsOpen;
+	}
+
+	const char* MemoryMappedFile::GetData() const
+	{
+		return m_pData;
+	}
+
+	size_t MemoryMappedFile::GetSize() const
+	{
+		return m_Size;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace dae
+{
+	//Read only view of a whole file, the os pages it in when it is first touched instead of copying it through a stream
+	class MemoryMappedFile final
+	{
+	public:
+		explicit MemoryMappedFile(const std::string& path);
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile&) = delete;
+		MemoryMappedFile(MemoryMappedFile&&) noexcept = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+		MemoryMappedFile& operator=(MemoryMappedFile&&) noexcept = delete;
+
+		//false when the file could not be opened or mapped
+		bool IsOpen() const;
+
+		//page aligned, nullptr for an empty file
+		const char* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const char* m_pData{};
+		size_t m_Size{};
+		bool m_IsOpen{};
+
+#if defined(_WIN32)
+		void* m_pFileHandle{};
+		void* m_pMappingHandle{};
+#endif
+	};
+}
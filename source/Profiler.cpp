@@ -0,0 +1,203 @@
+#include "Profiler.h"
+
+#if defined(ENABLE_PROFILER)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace dae
+{
+	namespace Profiler
+	{
+		struct Zone
+		{
+			const char* pName{};
+			int64_t startTime{};
+			int64_t endTime{};
+		};
+
+		//Only the thread that owns the ring writes to it. It publishes a zone by increasing the head after the zone is written,
+		//the exporter reads up to the head it sees. The counters are only ever added to by the owner, so relaxed loads and stores are enough
+		struct ThreadRecord
+		{
+			static constexpr uint64_t capacity{ 1 << 16 }; //a power of 2, so the head is wrapped with a mask
+
+			Zone zones[capacity]{};
+			std::atomic<uint64_t> head{};
+			std::atomic<uint64_t> counters[static_cast<int>(ProfileCounter::amountOfCounters)]{};
+			int threadId{};
+			ThreadRecord* pNext{};
+		};
+
+		struct FrameCounters
+		{
+			int64_t time{};
+			uint64_t values[static_cast<int>(ProfileCounter::amountOfCounters)]{};
+		};
+
+		//The records are pushed on a lock free list the first time a thread records something, they are kept after the thread exits
+		static std::atomic<ThreadRecord*> g_pFirstThreadRecord{};
+		static std::atomic<int> g_AmountOfThreads{};
+		static thread_local ThreadRecord* g_pThreadRecord{};
+
+		static const std::chrono::steady_clock::time_point g_StartTime{ std::chrono::steady_clock::now() };
+
+		//the totals at the end of every frame, only touched by EndFrame
+		static std::vector<FrameCounters> g_Frames{};
+		static uint64_t g_LastFrameCounters[static_cast<int>(ProfileCounter::amountOfCounters)]{};
+
+		//frees the records when the program exits
+		static struct ThreadRecordOwner
+		{
+			~ThreadRecordOwner()
+			{
+				ThreadRecord* pRecord{ g_pFirstThreadRecord.exchange(nullptr) };
+				while (pRecord)
+				{
+					ThreadRecord* pNext{ pRecord->pNext };
+					delete pRecord;
+					pRecord = pNext;
+				}
+			}
+		} g_ThreadRecordOwner{};
+
+		static ThreadRecord* GetThreadRecord()
+		{
+			if (g_pThreadRecord)
+				return g_pThreadRecord;
+
+			ThreadRecord* pRecord{ new ThreadRecord{} };
+			pRecord->threadId = g_AmountOfThreads++;
+			pRecord->pNext = g_pFirstThreadRecord.load();
+			while (!g_pFirstThreadRecord.compare_exchange_weak(pRecord->pNext, pRecord))
+			{
+			}
+
+			g_pThreadRecord = pRecord;
+			return pRecord;
+		}
+
+		static uint64_t SumCounter(int counterIndex)
+		{
+			uint64_t sum{};
+			for (ThreadRecord* pRecord{ g_pFirstThreadRecord.load() }; pRecord; pRecord = pRecord->pNext)
+			{
+				sum += pRecord->counters[counterIndex].load(std::memory_order_relaxed);
+			}
+			return sum;
+		}
+
+		void RecordZone(const char* pName, int64_t startTime, int64_t endTime)
+		{
+			ThreadRecord* pRecord{ GetThreadRecord() };
+			const uint64_t head{ pRecord->head.load(std::memory_order_relaxed) };
+			pRecord->zones[head & (ThreadRecord::capacity - 1)] = { pName, startTime, endTime };
+			pRecord->head.store(head + 1, std::memory_order_release);
+		}
+
+		void AddToCounter(ProfileCounter counter, uint64_t amount)
+		{
+			std::atomic<uint64_t>& value{ GetThreadRecord()->counters[static_cast<int>(counter)] };
+			value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		int64_t GetTime()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_StartTime).count();
+		}
+
+		void EndFrame()
+		{
+			//the counters only grow, a frame is the difference with the totals of the previous frame
+			FrameCounters frame{ GetTime() };
+			for (int counterIndex{}; counterIndex < static_cast<int>(ProfileCounter::amountOfCounters); ++counterIndex)
+			{
+				frame.values[counterIndex] = SumCounter(counterIndex);
+				g_LastFrameCounters[counterIndex] = frame.values[counterIndex] - (g_Frames.empty() ? 0 : g_Frames.back().values[counterIndex]);
+			}
+			g_Frames.emplace_back(frame);
+		}
+
+		uint64_t GetFrameCounter(ProfileCounter counter)
+		{
+			return g_LastFrameCounters[static_cast<int>(counter)];
+		}
+
+		bool ExportChromeTrace(const char* pFilePath)
+		{
+			std::ofstream file{ pFilePath };
+			if (!file)
+				return true;
+
+			//chrome://tracing expects microseconds
+			file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			bool isFirstEvent{ true };
+			const auto separate{ [&]()
+				{
+					if (!isFirstEvent)
+						file << ",\n";
+					isFirstEvent = false;
+				} };
+
+			for (ThreadRecord* pRecord{ g_pFirstThreadRecord.load() }; pRecord; pRecord = pRecord->pNext)
+			{
+				separate();
+				file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << pRecord->threadId
+					<< ",\"args\":{\"name\":\"thread " << pRecord->threadId << "\"}}";
+
+				const uint64_t head{ pRecord->head.load(std::memory_order_acquire) };
+				const uint64_t first{ head > ThreadRecord::capacity ? head - ThreadRecord::capacity : 0 };
+				for (uint64_t index{ first }; index < head; ++index)
+				{
+					const Zone& zone{ pRecord->zones[index & (ThreadRecord::capacity - 1)] };
+					separate();
+					file << "{\"name\":\"" << zone.pName << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << pRecord->threadId
+						<< ",\"ts\":" << zone.startTime / 1000.0 << ",\"dur\":" << (zone.endTime - zone.startTime) / 1000.0 << "}";
+				}
+			}
+
+			//counter events are plotted per name, the triangles and the fragments get their own graph because of their scale
+			const auto writeCounters{ [&](const char* pName, const FrameCounters& frame, const FrameCounters& previousFrame, std::initializer_list<std::pair<ProfileCounter, const char*>> counters)
+				{
+					separate();
+					file << "{\"name\":\"" << pName << "\",\"ph\":\"C\",\"pid\":0,\"ts\":" << frame.time / 1000.0 << ",\"args\":{";
+					bool isFirstCounter{ true };
+					for (const auto& [counter, pCounterName] : counters)
+					{
+						const int counterIndex{ static_cast<int>(counter) };
+						file << (isFirstCounter ? "" : ",") << "\"" << pCounterName << "\":" << frame.values[counterIndex] - previousFrame.values[counterIndex];
+						isFirstCounter = false;
+					}
+					file << "}}";
+				} };
+
+			for (size_t frameIndex{}; frameIndex < g_Frames.size(); ++frameIndex)
+			{
+				const FrameCounters& frame{ g_Frames[frameIndex] };
+				const FrameCounters& previousFrame{ frameIndex > 0 ? g_Frames[frameIndex - 1] : FrameCounters{} };
+
+				writeCounters("triangles", frame, previousFrame,
+					{
+						{ ProfileCounter::trianglesSubmitted, "submitted" },
+						{ ProfileCounter::trianglesCulled, "culled" },
+						{ ProfileCounter::trianglesClipped, "clipped" }
+					});
+				writeCounters("fragments", frame, previousFrame,
+					{
+						{ ProfileCounter::fragmentsTested, "tested" },
+						{ ProfileCounter::fragmentsPassed, "passed" },
+						{ ProfileCounter::fragmentsShaded, "shaded" }
+					});
+				writeCounters("Hi-Z rejected blocks", frame, previousFrame, { { ProfileCounter::hiZRejectedBlocks, "blocks" } });
+				writeCounters("texture samples", frame, previousFrame, { { ProfileCounter::textureSamples, "samples" } });
+			}
+
+			file << "\n]}\n";
+			return !file;
+		}
+	}
+}
+#endif
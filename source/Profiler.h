@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+
+//Uncomment to record zones and counters, without it every PROFILE_ macro compiles to nothing and the profiler is not built
+//#define ENABLE_PROFILER
+
+namespace dae
+{
+	enum class ProfileCounter
+	{
+		trianglesSubmitted, //every triangle of the index buffers
+		trianglesCulled, //outside of the frustum, facing away, degenerate or between the pixel centers
+		trianglesClipped, //crossed the near or far plane or the guard band and went through the clipper
+		fragmentsTested, //covered pixels that were depth tested
+		fragmentsPassed,
+		fragmentsShaded,
+		hiZRejectedBlocks,
+		textureSamples,
+		amountOfCounters
+	};
+}
+
+#if defined(ENABLE_PROFILER)
+namespace dae
+{
+	namespace Profiler
+	{
+		//Every thread records its zones in its own ring buffer, so recording never waits on another thread.
+		//When a buffer is full the oldest zones of that thread are overwritten
+		void RecordZone(const char* pName, int64_t startTime, int64_t endTime);
+		void AddToCounter(ProfileCounter counter, uint64_t amount);
+
+		//nanoseconds since the profiler started
+		int64_t GetTime();
+
+		//Takes the counters of the frame that ended, has to be called while no other thread records
+		void EndFrame();
+		uint64_t GetFrameCounter(ProfileCounter counter);
+
+		//Writes the zones and the counters of every frame in the json format of chrome://tracing and Perfetto,
+		//has to be called while no other thread records. Returns true when the file could not be written
+		bool ExportChromeTrace(const char* pFilePath);
+
+		//Records the time between its construction and destruction, pName has to outlive the profiler
+		class ScopedZone final
+		{
+		public:
+			explicit ScopedZone(const char* pName)
+				: m_pName{ pName }
+				, m_StartTime{ GetTime() }
+			{
+			}
+
+			~ScopedZone()
+			{
+				RecordZone(m_pName, m_StartTime, GetTime());
+			}
+
+			ScopedZone(const ScopedZone&) = delete;
+			ScopedZone(ScopedZone&&) noexcept = delete;
+			ScopedZone& operator=(const ScopedZone&) = delete;
+			ScopedZone& operator=(ScopedZone&&) noexcept = delete;
+
+		private:
+			const char* m_pName{};
+			int64_t m_StartTime{};
+		};
+	}
+}
+
+#define PROFILE_CONCATENATE_IMPLEMENTATION(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_IMPLEMENTATION(a, b)
+
+#define PROFILE_ZONE(name) const dae::Profiler::ScopedZone PROFILE_CONCATENATE(profileZone, __LINE__){ name }
+#define PROFILE_COUNT(counter, amount) dae::Profiler::AddToCounter(dae::ProfileCounter::counter, amount)
+#define PROFILE_END_FRAME() dae::Profiler::EndFrame()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNT(counter, amount)
+#define PROFILE_END_FRAME()
+
+#endif
@@ -8,10 +8,35 @@
 #include "Matrix.h"
 #include "Texture.h"
 #include "Utils.h"
+#include "Simd.h"
+#include "Profiler.h"
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <chrono>
+#include <type_traits>
+#include <new>
+
+#define PARALLEL_EXECUTION
+
 using namespace dae;
 
+//The owned color and depth buffers start on a cache line
+static constexpr std::align_val_t g_BufferAlignment{ 64 };
+
+template<typename T>
+static T* AllocateBuffer(int amountOfPixels)
+{
+	return static_cast<T*>(::operator new[](amountOfPixels * sizeof(T), g_BufferAlignment));
+}
+
+static void FreeBuffer(void* pBuffer)
+{
+	::operator delete[](pBuffer, g_BufferAlignment);
+}
+
 Renderer::Renderer(SDL_Window* pWindow) :
 	m_pWindow(pWindow)
 {
@@ -19,23 +44,90 @@ Renderer::Renderer(SDL_Window* pWindow) :
 	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
 	//Create Buffers
+	//the frame is rendered straight into the window surface when it is XRGB8888 without padding,
+	//any other window format gets an owned back buffer that is converted when it is blitted to the window
 	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;	
+	if (m_pFrontBuffer->format->format == SDL_PIXELFORMAT_RGB888 && m_pFrontBuffer->pitch == m_Width * static_cast<int>(sizeof(uint32_t)))
+	{
+		m_pBackBuffer = m_pFrontBuffer;
+	}
+	else
+	{
+		CreateOwnedBackBuffer();
+	}
+
+	Initialize();
+}
+
+Renderer::Renderer(int width, int height) :
+	m_Width(width),
+	m_Height(height)
+{
+	//there is no window to present to, the frame stays in the owned back buffer
+	CreateOwnedBackBuffer();
+
+	Initialize();
+}
+
+void Renderer::CreateOwnedBackBuffer()
+{
+	m_pOwnedColorBufferPixels = AllocateBuffer<uint32_t>(m_Width * m_Height);
+
+	//the surface only wraps the pixels, so SDL can still blit and save them
+	m_pBackBuffer = SDL_CreateRGBSurfaceWithFormatFrom(m_pOwnedColorBufferPixels, m_Width, m_Height, 32, m_Width * static_cast<int>(sizeof(uint32_t)), SDL_PIXELFORMAT_RGB888);
+}
+
+void Renderer::Initialize()
+{
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
 
 	const int amountOfPixels{ m_Width * m_Height };
-	m_pDepthBufferPixels = new float[amountOfPixels];
+	m_pDepthBufferPixels = AllocateBuffer<float>(amountOfPixels);
 	//fill depth buffer with ifiniy as value
 	for (int index{}; index < amountOfPixels; ++index)
 	{
 		m_pDepthBufferPixels[index] = INFINITY;
 	}
 
+	m_pVisibilityBufferPixels = new uint32_t[amountOfPixels]{};
+
+	//divide the screen in tiles, every tile owns its part of the back buffer and depth buffer
+	m_AmountOfTilesX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_AmountOfTilesY = (m_Height + m_TileSize - 1) / m_TileSize;
+	m_TileBins.resize(m_AmountOfTilesX * m_AmountOfTilesY);
+	m_TileIndices.resize(m_AmountOfTilesX * m_AmountOfTilesY);
+	std::iota(m_TileIndices.begin(), m_TileIndices.end(), 0);
+	m_pTileRenderTimes = new double[m_AmountOfTilesX * m_AmountOfTilesY]{};
+	m_pTileShadeTimes = new double[m_AmountOfTilesX * m_AmountOfTilesY]{};
+
+	m_HiZWidth = (m_Width + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_HiZHeight = (m_Height + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_pHiZBufferPixels = new float[m_HiZWidth * m_HiZHeight];
+	m_pHiZIsDirty = new bool[m_HiZWidth * m_HiZHeight];
+
+	m_SimdWidth = GetSimdWidth();
+	if (m_SimdWidth > 0)
+	{
+		m_RasterBackend = RasterBackend::simd;
+	}
+
 	m_pCombustionEffectDiffuseMap = Texture::LoadFromFile("Resources/fireFX_diffuse.png");
-	m_pVehicleDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
-	m_pNormalMap = Texture::LoadFromFile("Resources/vehicle_normal.png");
-	m_pSpecularMap = Texture::LoadFromFile("Resources/vehicle_specular.png");
-	m_pGlossinessMap = Texture::LoadFromFile("Resources/vehicle_gloss.png");
+
+	//the vehicle maps are packed at load, the separate maps are not needed after that
+	{
+		const Texture* pDiffuseMap{ Texture::LoadFromFile("Resources/vehicle_diffuse.png") };
+		const Texture* pNormalMap{ Texture::LoadFromFile("Resources/vehicle_normal.png") };
+		const Texture* pSpecularMap{ Texture::LoadFromFile("Resources/vehicle_specular.png") };
+		const Texture* pGlossinessMap{ Texture::LoadFromFile("Resources/vehicle_gloss.png") };
+
+		m_pVehicleDiffuseGlossinessMap = Texture::PackDiffuseGlossiness(*pDiffuseMap, *pGlossinessMap);
+		m_pVehicleNormalSpecularMap = Texture::PackNormalSpecular(*pNormalMap, *pSpecularMap);
+
+		delete pDiffuseMap;
+		delete pNormalMap;
+		delete pSpecularMap;
+		delete pGlossinessMap;
+	}
 
 	m_MeshesWorld = { Mesh{}, Mesh{} };
 	m_MeshesWorld[0].primitiveTopology = PrimitiveTopology::TriangeList;
@@ -43,8 +135,18 @@ Renderer::Renderer(SDL_Window* pWindow) :
 	m_MeshesWorld[0].cullMode = CullMode::FrontFaceCulling;
 	m_MeshesWorld[1].cullMode = CullMode::NoCulling;
 
-	Utils::ParseOBJ("Resources/vehicle.obj", m_MeshesWorld[0].vertices, m_MeshesWorld[0].indices);
-	Utils::ParseOBJ("Resources/fireFX.obj", m_MeshesWorld[1].vertices, m_MeshesWorld[1].indices);
+	//the vehicle is lit, the fire is blended over it without hiding what is behind it
+	m_MeshesWorld[0].material = { ShadingModel::phong, BlendMode::opaque, true, m_pVehicleDiffuseGlossinessMap, m_pVehicleNormalSpecularMap };
+	m_MeshesWorld[1].material = { ShadingModel::unlit, BlendMode::alphaBlend, false, m_pCombustionEffectDiffuseMap };
+
+	Utils::LoadMesh("Resources/vehicle.obj", m_MeshesWorld[0].vertices, m_MeshesWorld[0].indices);
+	Utils::LoadMesh("Resources/fireFX.obj", m_MeshesWorld[1].vertices, m_MeshesWorld[1].indices);
+
+	//the transformed vertices are allocated once, the vertex stage only overwrites them
+	for (Mesh& mesh : m_MeshesWorld)
+	{
+		mesh.InitializeStreams();
+	}
 
 	m_MeshesWorld[0].worldMatrix =
 	{
@@ -70,11 +172,21 @@ Renderer::Renderer(SDL_Window* pWindow) :
 
 Renderer::~Renderer()
 {
-	delete[] m_pDepthBufferPixels;
-	delete m_pVehicleDiffuseTexture;
-	delete m_pNormalMap;
-	delete m_pSpecularMap;
-	delete m_pGlossinessMap;
+	if (m_pBackBuffer != m_pFrontBuffer)
+	{
+		SDL_FreeSurface(m_pBackBuffer);
+	}
+	FreeBuffer(m_pOwnedColorBufferPixels);
+
+	FreeBuffer(m_pDepthBufferPixels);
+	delete[] m_pVisibilityBufferPixels;
+	delete[] m_pHiZBufferPixels;
+	delete[] m_pHiZIsDirty;
+	delete[] m_pTileRenderTimes;
+	delete[] m_pTileShadeTimes;
+	delete m_pCombustionEffectDiffuseMap;
+	delete m_pVehicleDiffuseGlossinessMap;
+	delete m_pVehicleNormalSpecularMap;
 }
 
 void Renderer::Update(Timer* pTimer)
@@ -91,16 +203,45 @@ void Renderer::Update(Timer* pTimer)
 	}
 }
 
+void Renderer::ApplyCameraKeyframe(const CameraKeyframe& keyframe)
+{
+	m_Camera.Initialize(keyframe.fovAngle, keyframe.origin, static_cast<float>(m_Width) / m_Height);
+	m_Camera.totalYaw = keyframe.yaw * TO_RADIANS;
+	m_Camera.totalPitch = keyframe.pitch * TO_RADIANS;
+	m_Camera.CalculateViewMatrix();
+	m_Camera.CalculateProjectionMatrix();
+
+	for (Mesh& mesh : m_MeshesWorld)
+	{
+		mesh.rotationAngle = keyframe.sceneRotation * TO_RADIANS;
+		mesh.worldMatrix = Matrix::CreateRotationY(mesh.rotationAngle) * Matrix::CreateTranslation(mesh.worldMatrix.GetTranslation());
+	}
+}
+
+const Renderer::FrameStatistics& Renderer::GetFrameStatistics() const
+{
+	return m_FrameStatistics;
+}
+
 void Renderer::Render()
 {
+	PROFILE_ZONE("Frame");
+	const auto clearStart{ std::chrono::steady_clock::now() };
+
 	//@START
 	Uint8 redValue{ 100 };
 	Uint8 greenValue{ 100 };
 	Uint8 blueValue{ 100 };
 	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, INFINITY);
-	SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB( m_pBackBuffer->format, redValue, greenValue, blueValue));
+	std::fill_n(m_pHiZBufferPixels, m_HiZWidth * m_HiZHeight, INFINITY);
+	std::fill_n(m_pHiZIsDirty, m_HiZWidth * m_HiZHeight, false);
 	//Lock BackBuffer
 	SDL_LockSurface(m_pBackBuffer);
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	std::fill_n(m_pBackBufferPixels, m_Width * m_Height, PackColor(redValue, greenValue, blueValue));
+
+	const std::chrono::duration<double, std::milli> clearDuration{ std::chrono::steady_clock::now() - clearStart };
+	m_FrameStatistics.clear = clearDuration.count();
 
 	//RENDER LOGIC
 	//W1_Part1();
@@ -120,9 +261,22 @@ void Renderer::Render()
 
 	//@END
 	//Update SDL Surface
+	const auto presentStart{ std::chrono::steady_clock::now() };
 	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (m_pWindow)
+	{
+		PROFILE_ZONE("Present");
+		if (m_pBackBuffer != m_pFrontBuffer)
+		{
+			SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		}
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+
+	const std::chrono::duration<double, std::milli> presentDuration{ std::chrono::steady_clock::now() - presentStart };
+	m_FrameStatistics.present = presentDuration.count();
+
+	PROFILE_END_FRAME();
 }
 
 void Renderer::VertexTransformationFunction(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const
@@ -156,39 +310,241 @@ void Renderer::VertexTransformationFunction(const std::vector<Vertex>& vertices_
 	}
 }
 
+//a clip space position p is on the inside of a plane when Dot(plane, p) >= 0
+//x and y are only clipped against a guard band, the bounding box takes care of the rest of the screen
+static constexpr float g_GuardBand{ 8.f };
+static constexpr int g_AmountOfClipPlanes{ 6 };
+static const Vector4 g_FrustumPlanes[g_AmountOfClipPlanes]
+{
+	{ 0.f, 0.f, 1.f, 0.f },  //near
+	{ 0.f, 0.f, -1.f, 1.f }, //far
+	{ 1.f, 0.f, 0.f, 1.f },  //left
+	{ -1.f, 0.f, 0.f, 1.f }, //right
+	{ 0.f, 1.f, 0.f, 1.f },  //bottom
+	{ 0.f, -1.f, 0.f, 1.f }  //top
+};
+static const Vector4 g_ClipPlanes[g_AmountOfClipPlanes]
+{
+	g_FrustumPlanes[0],
+	g_FrustumPlanes[1],
+	{ 1.f, 0.f, 0.f, g_GuardBand },
+	{ -1.f, 0.f, 0.f, g_GuardBand },
+	{ 0.f, 1.f, 0.f, g_GuardBand },
+	{ 0.f, -1.f, 0.f, g_GuardBand }
+};
+
+static uint8_t GetOutcode(const Vector4& position, const Vector4* pPlanes)
+{
+	uint8_t outcode{};
+	for (int planeIndex{}; planeIndex < g_AmountOfClipPlanes; ++planeIndex)
+	{
+		if (Vector4::Dot(pPlanes[planeIndex], position) < 0.f)
+		{
+			outcode |= 1 << planeIndex;
+		}
+	}
+	return outcode;
+}
+
+//Perspective divide and viewport transform, w keeps 1 / w for the perspective correct interpolation
+static void SetScreenPosition(TransformedVertices& vertices, size_t index, const Vector4& position, float width, float height)
+{
+	const float wInversed{ 1.f / position.w };
+	vertices.x[index] = 0.5f * (position.x * wInversed + 1.f) * width;
+	vertices.y[index] = 0.5f * (1.f - position.y * wInversed) * height;
+	vertices.z[index] = position.z * wInversed;
+	vertices.w[index] = wInversed;
+}
+
 void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshes_world)
 {
+	PROFILE_ZONE("Vertex transformation");
+
+	const float width{ static_cast<float>(m_Width) };
+	const float height{ static_cast<float>(m_Height) };
+
 	for (Mesh& mesh : meshes_world)
 	{
-		mesh.vertices_out.clear();
+		//meshes that are created on the fly have no streams yet
+		if (mesh.vertexStreams.Size() != mesh.vertices.size())
+		{
+			mesh.InitializeStreams();
+		}
+
+		TransformedVertices& vertices_out{ mesh.vertices_out };
+		const size_t amountOfVertices{ mesh.vertices.size() };
+
+		//drops the vertices the clipper added last frame
+		vertices_out.Resize(amountOfVertices);
+		mesh.indices_out.clear();
 		Matrix worldViewProjectionMatirx{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
 
-		for (const Vertex& vertex : mesh.vertices)
+		//transform a block of vertices in a batch and map it to the screen while it is still in the cache
+		//a vertex that needs clipping gets its screen position replaced by the clipper
+		constexpr size_t blockSize{ 256 };
+		for (size_t first{}; first < amountOfVertices; first += blockSize)
+		{
+			const size_t amountOfBlockVertices{ std::min(blockSize, amountOfVertices - first) };
+			Matrix::TransformVertices(worldViewProjectionMatirx, mesh.worldMatrix, m_Camera.origin, mesh.vertexStreams.GetStreams(first), amountOfBlockVertices, vertices_out.GetStreams(first));
+
+			for (size_t index{ first }; index < first + amountOfBlockVertices; ++index)
+			{
+				const Vector4 position{ vertices_out.x[index], vertices_out.y[index], vertices_out.z[index], vertices_out.w[index] };
+				vertices_out.frustumOutcodes[index] = GetOutcode(position, g_FrustumPlanes);
+				vertices_out.clipOutcodes[index] = GetOutcode(position, g_ClipPlanes);
+				SetScreenPosition(vertices_out, index, position, width, height);
+			}
+		}
+
+		int maxCount{};
+		int increment{};
+
+		if (mesh.primitiveTopology == PrimitiveTopology::TriangeList)
+		{
+			increment = 3;
+			maxCount = static_cast<int>(mesh.indices.size());
+		}
+		else
+		{
+			increment = 1;
+			maxCount = static_cast<int>(mesh.indices.size()) - 2;
+		}
+
+		PROFILE_COUNT(trianglesSubmitted, std::max(maxCount, 0) / increment);
+
+		for (int index{}; index < maxCount; index += increment)
+		{
+			uint32_t index0{ mesh.indices[index] };
+			uint32_t index1{ mesh.indices[index + 1] };
+			uint32_t index2{ mesh.indices[index + 2] };
+
+			if (index0 == index1 || index1 == index2 || index2 == index0)
+			{
+				PROFILE_COUNT(trianglesCulled, 1);
+				continue;
+			}
+
+			//every odd triangle in a strip has the opposite winding order
+			if (mesh.primitiveTopology == PrimitiveTopology::TriangleStrip && index & 0x01)
+			{
+				std::swap(index1, index2);
+			}
+
+			ClipTriangle(mesh, worldViewProjectionMatirx, index0, index1, index2);
+		}
+	}
+}
+
+//Appends a vertex with the attributes linearly interpolated between two vertices, only valid for clip space positions
+static uint32_t AddLerpedVertex(TransformedVertices& vertices, uint32_t from, uint32_t to, float factor)
+{
+	for (std::vector<float>* pStream : { &vertices.u, &vertices.v, &vertices.normalX, &vertices.normalY, &vertices.normalZ,
+		&vertices.tangentX, &vertices.tangentY, &vertices.tangentZ, &vertices.viewDirectionX, &vertices.viewDirectionY, &vertices.viewDirectionZ })
+	{
+		std::vector<float>& stream{ *pStream };
+		stream.push_back(stream[from] + (stream[to] - stream[from]) * factor);
+	}
+
+	//the position is filled in by the clipper
+	for (std::vector<float>* pStream : { &vertices.x, &vertices.y, &vertices.z, &vertices.w })
+	{
+		pStream->push_back(0.f);
+	}
+	vertices.frustumOutcodes.push_back(0);
+	vertices.clipOutcodes.push_back(0);
+
+	return static_cast<uint32_t>(vertices.Size() - 1);
+}
+
+void Renderer::ClipTriangle(Mesh& mesh, const Matrix& worldViewProjectionMatrix, uint32_t index0, uint32_t index1, uint32_t index2) const
+{
+	TransformedVertices& vertices{ mesh.vertices_out };
+
+	//all vertices outside of the same plane, the triangle can't be visible
+	if (vertices.frustumOutcodes[index0] & vertices.frustumOutcodes[index1] & vertices.frustumOutcodes[index2])
+	{
+		PROFILE_COUNT(trianglesCulled, 1);
+		return;
+	}
+
+	const int outcode{ vertices.clipOutcodes[index0] | vertices.clipOutcodes[index1] | vertices.clipOutcodes[index2] };
+
+	if (outcode == 0)
+	{
+		mesh.indices_out.push_back(index0);
+		mesh.indices_out.push_back(index1);
+		mesh.indices_out.push_back(index2);
+		return;
+	}
+
+	PROFILE_COUNT(trianglesClipped, 1);
+
+	//the vertex stage only kept the screen positions, clipping is rare enough to transform the corners again
+	const auto getClipPosition{ [&](uint32_t index)
+		{
+			const Vector3& position{ mesh.vertices[index].position };
+			return worldViewProjectionMatrix.TransformPoint({ position.x, position.y, position.z, 1.f });
+		} };
+
+	//Sutherland-Hodgman, every plane can add at most one vertex to the polygon
+	constexpr int maxAmountOfVertices{ 3 + g_AmountOfClipPlanes };
+	uint32_t polygon[maxAmountOfVertices]{ index0, index1, index2 };
+	Vector4 positions[maxAmountOfVertices]{ getClipPosition(index0), getClipPosition(index1), getClipPosition(index2) };
+	uint32_t clippedPolygon[maxAmountOfVertices]{};
+	Vector4 clippedPositions[maxAmountOfVertices]{};
+	int amountOfVertices{ 3 };
+
+	for (int planeIndex{}; planeIndex < g_AmountOfClipPlanes; ++planeIndex)
+	{
+		if (!(outcode & (1 << planeIndex)))
+			continue;
+
+		const Vector4& plane{ g_ClipPlanes[planeIndex] };
+		int amountOfClippedVertices{};
+
+		for (int vertexIndex{}; vertexIndex < amountOfVertices; ++vertexIndex)
 		{
-			Vertex_Out vertexOut{};
+			const int nextIndex{ (vertexIndex + 1) % amountOfVertices };
+
+			const float currentDistance{ Vector4::Dot(plane, positions[vertexIndex]) };
+			const float nextDistance{ Vector4::Dot(plane, positions[nextIndex]) };
 
-			vertexOut.position = worldViewProjectionMatirx.TransformPoint({ vertex.position.x, vertex.position.y, vertex.position.z, 0 });
+			if (currentDistance >= 0.f)
+			{
+				clippedPositions[amountOfClippedVertices] = positions[vertexIndex];
+				clippedPolygon[amountOfClippedVertices++] = polygon[vertexIndex];
+			}
+
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+			{
+				const float factor{ currentDistance / (currentDistance - nextDistance) };
+				const Vector4 intersection{ positions[vertexIndex] + (positions[nextIndex] - positions[vertexIndex]) * factor };
 
-			//perspective divide
-			const float wInversed{ 1.f / vertexOut.position.w };
-			vertexOut.position.x *= wInversed;
-			vertexOut.position.y *= wInversed;
-			vertexOut.position.z *= wInversed;
-			vertexOut.position.w = wInversed;
+				const uint32_t intersectionIndex{ AddLerpedVertex(vertices, polygon[vertexIndex], polygon[nextIndex], factor) };
+				SetScreenPosition(vertices, intersectionIndex, intersection, static_cast<float>(m_Width), static_cast<float>(m_Height));
 
-			//set color of the vertex
-			vertexOut.color = vertex.color;
-			//set uv of the vertex
-			vertexOut.uv = vertex.uv;
-			//set the normal of the vertex
-			vertexOut.normal = mesh.worldMatrix.TransformVector(vertex.normal);
-			//set the tangent of the vertex
-			vertexOut.tangent = mesh.worldMatrix.TransformVector(vertex.tangent);
-			//set the viewDirection of the vertex
-			vertexOut.viewDirection = m_Camera.origin - mesh.worldMatrix.TransformPoint(vertex.position);
+				clippedPositions[amountOfClippedVertices] = intersection;
+				clippedPolygon[amountOfClippedVertices++] = intersectionIndex;
+			}
+		}
 
-			mesh.vertices_out.emplace_back(vertexOut);
+		if (amountOfClippedVertices < 3)
+		{
+			PROFILE_COUNT(trianglesCulled, 1);
+			return;
 		}
+
+		std::copy_n(clippedPolygon, amountOfClippedVertices, polygon);
+		std::copy_n(clippedPositions, amountOfClippedVertices, positions);
+		amountOfVertices = amountOfClippedVertices;
+	}
+
+	//the clipped polygon is convex, so a fan keeps the winding order
+	for (int vertexIndex{ 1 }; vertexIndex < amountOfVertices - 1; ++vertexIndex)
+	{
+		mesh.indices_out.push_back(polygon[0]);
+		mesh.indices_out.push_back(polygon[vertexIndex]);
+		mesh.indices_out.push_back(polygon[vertexIndex + 1]);
 	}
 }
 
@@ -212,9 +568,9 @@ void Renderer::W1_Part1() const
 	vertices_screenSpace[2].x = (vertices_ndc[2].x + 1) / 2.f * m_Width;
 	vertices_screenSpace[2].y = (1 - vertices_ndc[2].y) / 2.f * m_Height;
 
-	for (int px{}; px < m_Width; ++px)
+	for (int py{}; py < m_Height; ++py)
 	{
-		for (int py{}; py < m_Height; ++py)
+		for (int px{}; px < m_Width; ++px)
 		{
 			Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 				  
@@ -237,10 +593,7 @@ void Renderer::W1_Part1() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 			}
 		}
 	}
@@ -257,9 +610,9 @@ void Renderer::W1_Part2() const
 	std::vector<Vertex> transformed_vertices_world{};
 	VertexTransformationFunction(vertices_world, transformed_vertices_world);
 
-	for (int px{}; px < m_Width; ++px)
+	for (int py{}; py < m_Height; ++py)
 	{
-		for (int py{}; py < m_Height; ++py)
+		for (int px{}; px < m_Width; ++px)
 		{
 			Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 
@@ -291,10 +644,7 @@ void Renderer::W1_Part2() const
 			//Update Color in Buffer
 			finalColor.MaxToOne();
 
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-				static_cast<uint8_t>(finalColor.r * 255),
-				static_cast<uint8_t>(finalColor.g * 255),
-				static_cast<uint8_t>(finalColor.b * 255));
+			m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 		}
 	}
 }
@@ -310,9 +660,9 @@ void Renderer::W1_Part3() const
 	std::vector<Vertex> transformed_vertices_world{};
 	VertexTransformationFunction(vertices_world, transformed_vertices_world);
 
-	for (int px{}; px < m_Width; ++px)
+	for (int py{}; py < m_Height; ++py)
 	{
-		for (int py{}; py < m_Height; ++py)
+		for (int px{}; px < m_Width; ++px)
 		{
 			Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 
@@ -347,10 +697,7 @@ void Renderer::W1_Part3() const
 			//Update Color in Buffer
 			finalColor.MaxToOne();
 
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-				static_cast<uint8_t>(finalColor.r * 255),
-				static_cast<uint8_t>(finalColor.g * 255),
-				static_cast<uint8_t>(finalColor.b * 255));
+			m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 		}
 	}
 }
@@ -375,9 +722,9 @@ void Renderer::W1_Part4() const
 	const int amountOfTriangles{ static_cast<int>(transformed_vertices_world.size()) / 3 };
 	for (int index{}; index < amountOfTriangles; ++index)
 	{
-		for (int px{}; px < m_Width; ++px)
+		for (int py{}; py < m_Height; ++py)
 		{
-			for (int py{}; py < m_Height; ++py)
+			for (int px{}; px < m_Width; ++px)
 			{
 				Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 
@@ -426,10 +773,7 @@ void Renderer::W1_Part4() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 			}
 		}
 	}
@@ -490,9 +834,9 @@ void Renderer::W1_Part5() const
 		max.y = std::max(max.y, v2.y);
 		max.y = std::min(max.y, static_cast<float>(m_Height));
 
-		for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+		for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 		{
-			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 			{
 				pixel = { static_cast<float>(px), static_cast<float>(py) };
 
@@ -538,10 +882,7 @@ void Renderer::W1_Part5() const
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -657,9 +998,9 @@ void Renderer::W2_Part1() const
 			max.y = std::max(max.y, v2.y);
 			max.y = std::min(max.y, static_cast<float>(m_Height));
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 				{
 					Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 
@@ -703,10 +1044,7 @@ void Renderer::W2_Part1() const
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -810,9 +1148,9 @@ void Renderer::W2_Part2() const
 			max.y = std::max(max.y, v2.y);
 			max.y = std::min(max.y, static_cast<float>(m_Height));
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 				{
 					Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
 
@@ -850,15 +1188,12 @@ void Renderer::W2_Part2() const
 
 					Vector2 interpolation{ vertex0.uv * w0 + vertex1.uv * w1 + vertex2.uv * w2 };
 					
-					ColorRGBA finalColor{ m_pVehicleDiffuseTexture->Sample(interpolation) };
+					ColorRGBA finalColor{ m_pVehicleDiffuseGlossinessMap->Sample(interpolation) };
 
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -962,9 +1297,9 @@ void Renderer::W2_Part3() const
 			max.y = std::max(max.y, v2.y);
 			max.y = std::min(max.y, static_cast<float>(m_Height));
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 				{
 					Vector2 pixel = { static_cast<float>(px), static_cast<float>(py) };
 
@@ -1020,15 +1355,12 @@ void Renderer::W2_Part3() const
 										 + (vertex2.uv * w2) / vertex2.position.z )
 					};
 
-					ColorRGBA finalColor = m_pVehicleDiffuseTexture->Sample(interpolatedUV);
+					ColorRGBA finalColor = m_pVehicleDiffuseGlossinessMap->Sample(interpolatedUV);
 
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -1076,12 +1408,6 @@ void Renderer::W3_Part1()
 	const int amountOfMeshes{ static_cast<int>(meshes_world.size()) };
 	for (Mesh& mesh : meshes_world)
 	{
-		for (Vertex_Out& vertex : mesh.vertices_out)
-		{
-			vertex.position.x = 0.5f * (vertex.position.x + 1.f) * m_Width;
-			vertex.position.y = 0.5f * (1.f - vertex.position.y) * m_Height;
-		}
-
 		int maxCount{};
 		int increment{};
 
@@ -1105,9 +1431,9 @@ void Renderer::W3_Part1()
 				continue;
 			}
 
-			Vertex_Out& vertex0{ mesh.vertices_out[mesh.indices[index]] };
-			Vertex_Out& vertex1{ mesh.vertices_out[mesh.indices[index + 1]] };
-			Vertex_Out& vertex2{ mesh.vertices_out[mesh.indices[index + 2]] };
+			const Vertex_Out vertex0{ mesh.vertices_out.GetVertex(mesh.indices[index]) };
+			const Vertex_Out vertex1{ mesh.vertices_out.GetVertex(mesh.indices[index + 1]) };
+			const Vertex_Out vertex2{ mesh.vertices_out.GetVertex(mesh.indices[index + 2]) };
 
 			if (vertex0.position.z < 0.f || vertex0.position.z > 1.f
 				|| vertex1.position.z < 0.f || vertex1.position.z > 1.f
@@ -1139,9 +1465,9 @@ void Renderer::W3_Part1()
 			max.y = std::max(max.y, v2.y);
 			max.y = std::min(max.y, static_cast<float>(m_Height));
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 				{
 					Vector2 pixel = { static_cast<float>(px), static_cast<float>(py) };
 
@@ -1229,15 +1555,12 @@ void Renderer::W3_Part1()
 										 + (vertex2.uv * w2) * vertex2.position.w)
 					};
 
-					ColorRGBA finalColor = m_pVehicleDiffuseTexture->Sample(interpolatedUV);
+					ColorRGBA finalColor = m_pVehicleDiffuseGlossinessMap->Sample(interpolatedUV);
 
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -1251,12 +1574,6 @@ void Renderer::W3_Part2()
 	const int amountOfMeshes{ static_cast<int>(m_MeshesWorld.size()) };
 	for (Mesh& mesh : m_MeshesWorld)
 	{
-		for (Vertex_Out& vertex : mesh.vertices_out)
-		{
-			vertex.position.x = 0.5f * (vertex.position.x + 1.f) * m_Width;
-			vertex.position.y = 0.5f * (1.f - vertex.position.y) * m_Height;
-		}
-
 		int maxCount{};
 		int increment{};
 
@@ -1280,9 +1597,9 @@ void Renderer::W3_Part2()
 				continue;
 			}
 
-			Vertex_Out& vertex0{ mesh.vertices_out[mesh.indices[index]] };
-			Vertex_Out& vertex1{ mesh.vertices_out[mesh.indices[index + 1]] };
-			Vertex_Out& vertex2{ mesh.vertices_out[mesh.indices[index + 2]] };
+			const Vertex_Out vertex0{ mesh.vertices_out.GetVertex(mesh.indices[index]) };
+			const Vertex_Out vertex1{ mesh.vertices_out.GetVertex(mesh.indices[index + 1]) };
+			const Vertex_Out vertex2{ mesh.vertices_out.GetVertex(mesh.indices[index + 2]) };
 
 			if (vertex0.position.z < 0.f || vertex0.position.z > 1.f
 				|| vertex1.position.z < 0.f || vertex1.position.z > 1.f
@@ -1314,9 +1631,9 @@ void Renderer::W3_Part2()
 			max.y = std::max(max.y, v2.y);
 			max.y = std::min(max.y, static_cast<float>(m_Height));
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
 				{
 					Vector2 pixel = { static_cast<float>(px), static_cast<float>(py) };
 
@@ -1411,7 +1728,7 @@ void Renderer::W3_Part2()
 											 + (vertex2.uv * w2) * vertex2.position.w)
 						};
 
-						finalColor = m_pVehicleDiffuseTexture->Sample(interpolatedUV);
+						finalColor = m_pVehicleDiffuseGlossinessMap->Sample(interpolatedUV);
 						break;
 
 					case dae::Renderer::RenderMode::observedArea:
@@ -1423,10 +1740,7 @@ void Renderer::W3_Part2()
 					//Update Color in Buffer
 					finalColor.MaxToOne();
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+					m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 				}
 			}
 		}
@@ -1435,334 +1749,1122 @@ void Renderer::W3_Part2()
 
 void Renderer::W4_Part1()
 {
+	const auto vertexStart{ std::chrono::steady_clock::now() };
+
 	VertexTransformationFunction(m_MeshesWorld);
-	random = 0;
-	int number{};
-	const int amountOfMeshes{ static_cast<int>(m_MeshesWorld.size()) };
-	for (Mesh& mesh : m_MeshesWorld)
-	{
-		for (Vertex_Out& vertex : mesh.vertices_out)
-		{
-			vertex.position.x = 0.5f * (vertex.position.x + 1.f) * m_Width;
-			vertex.position.y = 0.5f * (1.f - vertex.position.y) * m_Height;
-		}
+	BinTriangles();
 
-		int maxCount{};
-		int increment{};
+	const auto tilesStart{ std::chrono::steady_clock::now() };
+	const std::chrono::duration<double, std::milli> vertexDuration{ tilesStart - vertexStart };
+	m_FrameStatistics.vertex = vertexDuration.count();
 
-		if (mesh.primitiveTopology == PrimitiveTopology::TriangeList)
-		{
-			increment = 3;
-			maxCount = static_cast<int>(mesh.indices.size());
-		}
-		else
+	//rasterization: the tiles don't share any pixels so they can be rendered in parallel without locking
+#if defined(PARALLEL_EXECUTION)
+	m_FrameStatistics.hiZRejectedBlocks = std::transform_reduce(std::execution::par, m_TileIndices.begin(), m_TileIndices.end(), 0, std::plus<int>{}, [this](int tileIndex)
 		{
-			increment = 1;
-			maxCount = static_cast<int>(mesh.indices.size()) - 2;
-		}
+			return RenderTile(tileIndex);
+		});
+#else
+	m_FrameStatistics.hiZRejectedBlocks = 0;
+	for (int tileIndex : m_TileIndices)
+	{
+		m_FrameStatistics.hiZRejectedBlocks += RenderTile(tileIndex);
+	}
+#endif
 
-		for (int index{}; index < maxCount; index += increment)
+	const std::chrono::duration<double, std::milli> tilesDuration{ std::chrono::steady_clock::now() - tilesStart };
+	const double tileRenderTime{ std::accumulate(m_pTileRenderTimes, m_pTileRenderTimes + m_TileIndices.size(), 0.0) };
+	const double tileShadeTime{ std::accumulate(m_pTileShadeTimes, m_pTileShadeTimes + m_TileIndices.size(), 0.0) };
+	m_FrameStatistics.shade = tileRenderTime > 0.0 ? tilesDuration.count() * tileShadeTime / tileRenderTime : 0.0;
+	m_FrameStatistics.raster = tilesDuration.count() - m_FrameStatistics.shade;
+
+	PROFILE_COUNT(hiZRejectedBlocks, m_FrameStatistics.hiZRejectedBlocks);
+}
+
+void Renderer::BinTriangles()
+{
+	PROFILE_ZONE("Triangle setup and binning");
+
+	//binning: every triangle that survives culling is added to the bins of the tiles its bounding box overlaps
+	m_BinnedTriangles.clear();
+	for (std::vector<int>& tileBin : m_TileBins)
+	{
+		tileBin.clear();
+	}
+
+	//the shading permutation of every mesh is picked once from its material
+	m_MeshPermutations.resize(m_MeshesWorld.size());
+	for (size_t meshIndex{}; meshIndex < m_MeshesWorld.size(); ++meshIndex)
+	{
+		m_MeshPermutations[meshIndex] = SelectPermutation(m_MeshesWorld[meshIndex].material);
+	}
+
+	//opaque meshes are binned first and grouped by material so a tile keeps reading the same textures,
+	//blended meshes need what is behind them so they come last in the order they were submitted
+	std::vector<int> meshOrder(m_MeshesWorld.size());
+	std::iota(meshOrder.begin(), meshOrder.end(), 0);
+	std::stable_sort(meshOrder.begin(), meshOrder.end(), [this](int left, int right)
 		{
-			if (mesh.indices[index] == mesh.indices[index + 1]
-				|| mesh.indices[index + 1] == mesh.indices[index + 2]
-				|| mesh.indices[index + 2] == mesh.indices[index])
-			{
-				continue;
-			}
+			const Material& leftMaterial{ m_MeshesWorld[left].material };
+			const Material& rightMaterial{ m_MeshesWorld[right].material };
+			const bool isLeftBlended{ leftMaterial.blendMode != BlendMode::opaque };
+			const bool isRightBlended{ rightMaterial.blendMode != BlendMode::opaque };
 
-			Vertex_Out& vertex0{ mesh.vertices_out[mesh.indices[index]] };
-			Vertex_Out& vertex1{ mesh.vertices_out[mesh.indices[index + 1]] };
-			Vertex_Out& vertex2{ mesh.vertices_out[mesh.indices[index + 2]] };
+			if (isLeftBlended != isRightBlended)
+				return isRightBlended;
 
-			if (vertex0.position.z < 0.f || vertex0.position.z > 1.f
-				|| vertex1.position.z < 0.f || vertex1.position.z > 1.f
-				|| vertex2.position.z < 0.f || vertex2.position.z > 1.f) continue;
+			return !isLeftBlended && std::less<const Texture*>{}(leftMaterial.pDiffuseMap, rightMaterial.pDiffuseMap);
+		});
 
-			const Vector2 v0{ vertex0.position.x, vertex0.position.y };
-			const Vector2 v1{ vertex1.position.x, vertex1.position.y };
-			const Vector2 v2{ vertex2.position.x, vertex2.position.y };
+	for (int number : meshOrder)
+	{
+		Mesh& mesh{ m_MeshesWorld[number] };
 
-			Vector2 v1ToV2{ v2 - v1 };
-			Vector2 v2ToV0{ v0 - v2 };
-			Vector2 v0ToV1{ v1 - v0 };
+		//the vertex stage only outputs clipped triangle lists
+		for (size_t index{}; index < mesh.indices_out.size(); index += 3)
+		{
+			const TransformedVertices& vertices{ mesh.vertices_out };
+			const uint32_t index0{ mesh.indices_out[index] };
+			const uint32_t index1{ mesh.indices_out[index + 1] };
+			const uint32_t index2{ mesh.indices_out[index + 2] };
 
-			const float area{ Vector2::Cross(v0ToV1, v2 - v0) / 2.f };
+			const Vector2 v0{ vertices.x[index0], vertices.y[index0] };
+			const Vector2 v1{ vertices.x[index1], vertices.y[index1] };
+			const Vector2 v2{ vertices.x[index2], vertices.y[index2] };
+
+			const float area{ Vector2::Cross(v1 - v0, v2 - v0) / 2.f };
 
-			if (mesh.cullMode == CullMode::FrontFaceCulling && area > 0.f)
+			//facing away, degenerate triangles don't cover any pixels
+			const bool isFacingAway{ (mesh.cullMode == CullMode::FrontFaceCulling && area > 0.f) || (mesh.cullMode == CullMode::BackFaceCulling && area < 0.f) };
+			if (isFacingAway || area == 0.f)
 			{
-				++random;
+				PROFILE_COUNT(trianglesCulled, 1);
 				continue;
 			}
 
-			if (mesh.cullMode == CullMode::BackFaceCulling && area < 0.f)
+			Triangle triangle{ &vertices, index0, index1, index2, {}, {}, area, number, &mesh.material };
+			CalculateBoundingBox(v0, v1, v2, triangle.min, triangle.max);
+
+			//the triangle does not cover any pixel on the screen
+			if (static_cast<int>(triangle.min.x) >= triangle.max.x || static_cast<int>(triangle.min.y) >= triangle.max.y || !SetupTriangle(triangle))
+			{
+				PROFILE_COUNT(trianglesCulled, 1);
 				continue;
+			}
 
-			float w0{};
-			float w1{};
-			float w2{};
+			const int triangleIndex{ static_cast<int>(m_BinnedTriangles.size()) };
+			m_BinnedTriangles.emplace_back(triangle);
 
-			Vector2 min{};
-			Vector2 max{};
-			CalculateBoundingBox(v0, v1, v2, min, max);
+			const int firstTileX{ static_cast<int>(triangle.min.x) / m_TileSize };
+			const int firstTileY{ static_cast<int>(triangle.min.y) / m_TileSize };
+			const int lastTileX{ (static_cast<int>(std::ceil(triangle.max.x)) - 1) / m_TileSize };
+			const int lastTileY{ (static_cast<int>(std::ceil(triangle.max.y)) - 1) / m_TileSize };
 
-			for (int px{ static_cast<int>(min.x) }; px < max.x; ++px)
+			for (int tileY{ firstTileY }; tileY <= lastTileY; ++tileY)
 			{
-				for (int py{ static_cast<int>(min.y) }; py < max.y; ++py)
+				for (int tileX{ firstTileX }; tileX <= lastTileX; ++tileX)
 				{
-					Vector2 pixelPos = { static_cast<float>(px), static_cast<float>(py) };
+					m_TileBins[tileY * m_AmountOfTilesX + tileX].push_back(triangleIndex);
+				}
+			}
+		}
+	}
+}
 
-					if (!IsPixelInTriange(v0, v1, v2, pixelPos))
-						continue;
+int Renderer::RenderTile(int tileIndex) const
+{
+	PROFILE_ZONE("Rasterize tile");
+	const auto tileStart{ std::chrono::steady_clock::now() };
+	double shadeTime{};
+	const auto resolve{ [&]()
+		{
+			PROFILE_ZONE("Shade visibility buffer");
+			const auto resolveStart{ std::chrono::steady_clock::now() };
+			ResolveVisibilityBuffer(tileIndex);
+			const std::chrono::duration<double, std::milli> resolveDuration{ std::chrono::steady_clock::now() - resolveStart };
+			shadeTime += resolveDuration.count();
+		} };
 
-					if (mesh.primitiveTopology == PrimitiveTopology::TriangleStrip && index & 0x01)
-					{
-						w0 = (Vector2::Cross(v1ToV2, pixelPos - v1) / 2.f) / (-1 * area);
-						w1 = (Vector2::Cross(v2ToV0, pixelPos - v2) / 2.f) / (-1 * area);
-						w2 = (Vector2::Cross(v0ToV1, pixelPos - v0) / 2.f) / (-1 * area);
-					}
-					else if(mesh.primitiveTopology == PrimitiveTopology::TriangeList)
-					{
-						w0 = (Vector2::Cross(v1ToV2, pixelPos - v1) / 2.f) / area;
-						w1 = (Vector2::Cross(v2ToV0, pixelPos - v2) / 2.f) / area;
-						w2 = (Vector2::Cross(v0ToV1, pixelPos - v0) / 2.f) / area;
-					}
+	const int tileX{ tileIndex % m_AmountOfTilesX };
+	const int tileY{ tileIndex / m_AmountOfTilesX };
 
-					float depthInterpolated
-					{
-						1.f / ((1.f * w0) / vertex0.position.z
-							   + (1.f * w1) / vertex1.position.z
-							   + (1.f * w2) / vertex2.position.z)
-					};
+	const Vector2 tileMin{ static_cast<float>(tileX * m_TileSize), static_cast<float>(tileY * m_TileSize) };
+	const Vector2 tileMax{ static_cast<float>(std::min((tileX + 1) * m_TileSize, m_Width)), static_cast<float>(std::min((tileY + 1) * m_TileSize, m_Height)) };
 
-					int pixelIndex{ py * m_Width + px };
+	int amountOfRejectedBlocks{};
+	bool hasUnresolvedFragments{};
 
-					if (number == 1)
-					{
-						if (depthInterpolated >= m_pDepthBufferPixels[pixelIndex])
-							continue;
-					}
-					
-					if (number == 0)
-					{
-						if (depthInterpolated <= m_pDepthBufferPixels[pixelIndex])
-						{
-							m_pDepthBufferPixels[pixelIndex] = depthInterpolated;
-						}
-						else continue;
-					}
-					
-					float interpolatedCameraSpaceZ{};
-					ColorRGBA finalColor{};
-					Vector2 interpolatedUV{};
-					Vertex_Out pixel{};
-					
-					interpolatedCameraSpaceZ =
-					{
-						1.f / (  w0 * vertex0.position.w
-							   + w1 * vertex1.position.w
-							   + w2 * vertex2.position.w)
-					};
+	//the triangles are rendered in the order they were submitted so blending onto earlier meshes still works
+	for (int triangleIndex : m_TileBins[tileIndex])
+	{
+		const Triangle& triangle{ m_BinnedTriangles[triangleIndex] };
+		const ShadingPermutation& permutation{ m_MeshPermutations[triangle.meshIndex] };
 
-					pixel.uv =
-					{
-						interpolatedCameraSpaceZ *
-						(vertex0.uv * w0 * vertex0.position.w
-						+ vertex1.uv * w1 * vertex1.position.w
-						+ vertex2.uv * w2 * vertex2.position.w)
-					};
+		//blended meshes need the color of what is behind them, so the opaque pixels have to be shaded first
+		if (hasUnresolvedFragments && permutation.blendMode != BlendMode::opaque)
+		{
+			resolve();
+			hasUnresolvedFragments = false;
+		}
 
-					pixel.position =
-					{
-						pixelPos.x,
-						pixelPos.y,
-						depthInterpolated,
-						interpolatedCameraSpaceZ
-					};
+		const Vector2 min{ std::max(triangle.min.x, tileMin.x), std::max(triangle.min.y, tileMin.y) };
+		const Vector2 max{ std::min(triangle.max.x, tileMax.x), std::min(triangle.max.y, tileMax.y) };
 
-					pixel.normal =
-					{
-						Vector3{vertex0.normal * w0 * vertex0.position.w
-								+ vertex1.normal * w1 * vertex1.position.w
-								+ vertex2.normal * w2 * vertex2.position.w}.Normalized()
-					};
+		const int firstBlockX{ static_cast<int>(min.x) / m_HiZBlockSize };
+		const int firstBlockY{ static_cast<int>(min.y) / m_HiZBlockSize };
+		const int lastBlockX{ (static_cast<int>(std::ceil(max.x)) - 1) / m_HiZBlockSize };
+		const int lastBlockY{ (static_cast<int>(std::ceil(max.y)) - 1) / m_HiZBlockSize };
+		const int amountOfBlocksX{ lastBlockX - firstBlockX + 1 };
+		const int amountOfBlocks{ amountOfBlocksX * (lastBlockY - firstBlockY + 1) };
 
-					pixel.tangent =
-					{
-						Vector3{vertex0.tangent * w0 * vertex0.position.w
-								+ vertex1.tangent * w1 * vertex1.position.w
-								+ vertex2.tangent * w2 * vertex2.position.w}.Normalized()
-					};
+		//one bit per Hi-Z block of the bounding box, a tile holds at most 8x8 blocks
+		uint64_t occludedBlocks{};
+		int amountOfOccludedBlocks{};
+		for (int blockY{ firstBlockY }; blockY <= lastBlockY; ++blockY)
+		{
+			for (int blockX{ firstBlockX }; blockX <= lastBlockX; ++blockX)
+			{
+				if (IsBlockOccluded(blockX, blockY, triangle.nearestDepth, permutation.blendMode))
+				{
+					occludedBlocks |= uint64_t{ 1 } << ((blockY - firstBlockY) * amountOfBlocksX + (blockX - firstBlockX));
+					++amountOfOccludedBlocks;
+				}
+			}
+		}
 
-					pixel.viewDirection =
-					{
-						Vector3{vertex0.viewDirection * w0 * vertex0.position.w
-								+ vertex1.viewDirection * w1 * vertex1.position.w
-								+ vertex2.viewDirection * w2 * vertex2.position.w}
-					};
+		amountOfRejectedBlocks += amountOfOccludedBlocks;
 
-					finalColor = ShadePixel(pixel, number);
+		if (amountOfOccludedBlocks == amountOfBlocks)
+			continue;
 
-					if (number == 1)
-					{
-						Uint8 rValue{}, gValue{}, bValue{};
-						SDL_GetRGB(m_pBackBufferPixels[static_cast<int>(pixel.position.x) + (static_cast<int>(pixel.position.y) * m_Width)], m_pBackBuffer->format, &rValue, &gValue, &bValue);
+		if (amountOfOccludedBlocks == 0)
+		{
+			(this->*permutation.pRasterize)(triangle, min, max);
+		}
+		else
+		{
+			for (int blockY{ firstBlockY }; blockY <= lastBlockY; ++blockY)
+			{
+				for (int blockX{ firstBlockX }; blockX <= lastBlockX; ++blockX)
+				{
+					if (occludedBlocks & (uint64_t{ 1 } << ((blockY - firstBlockY) * amountOfBlocksX + (blockX - firstBlockX))))
+						continue;
 
-						finalColor.a = std::min(1.f, finalColor.a);
+					const Vector2 blockMin{ std::max(min.x, static_cast<float>(blockX * m_HiZBlockSize)), std::max(min.y, static_cast<float>(blockY * m_HiZBlockSize)) };
+					const Vector2 blockMax{ std::min(max.x, static_cast<float>((blockX + 1) * m_HiZBlockSize)), std::min(max.y, static_cast<float>((blockY + 1) * m_HiZBlockSize)) };
 
-						finalColor =
-						{
-							finalColor.a * finalColor.r + (1.f - finalColor.a) * (rValue / 255.f),
-							finalColor.a * finalColor.g + (1.f - finalColor.a) * (gValue / 255.f),
-							finalColor.a * finalColor.b + (1.f - finalColor.a) * (bValue / 255.f)
-						};
-					}
+					(this->*permutation.pRasterize)(triangle, blockMin, blockMax);
+				}
+			}
+		}
 
-					//Update Color in Buffer
-					finalColor.MaxToOne();
-					
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+		//the Hi-Z only has to be updated where depth was written
+		if (permutation.writesDepth)
+		{
+			hasUnresolvedFragments = hasUnresolvedFragments || permutation.isDeferred;
+
+			for (int blockY{ firstBlockY }; blockY <= lastBlockY; ++blockY)
+			{
+				for (int blockX{ firstBlockX }; blockX <= lastBlockX; ++blockX)
+				{
+					if (!(occludedBlocks & (uint64_t{ 1 } << ((blockY - firstBlockY) * amountOfBlocksX + (blockX - firstBlockX)))))
+					{
+						m_pHiZIsDirty[blockY * m_HiZWidth + blockX] = true;
+					}
 				}
 			}
 		}
-		++number;
 	}
-	std::cout << random << '\n';
+
+	if (hasUnresolvedFragments)
+	{
+		resolve();
+	}
+
+	const std::chrono::duration<double, std::milli> tileDuration{ std::chrono::steady_clock::now() - tileStart };
+	m_pTileRenderTimes[tileIndex] = tileDuration.count();
+	m_pTileShadeTimes[tileIndex] = shadeTime;
+
+	return amountOfRejectedBlocks;
 }
 
-bool Renderer::IsPixelInTriange(const Vector2& v0, const Vector2& v1, const Vector2& v2, const Vector2& pixelPos) const
+bool Renderer::IsBlockOccluded(int blockX, int blockY, float nearestDepth, BlendMode blendMode) const
 {
-	float cross1{ Vector2::Cross(v2 - v1, pixelPos - v1) };
-	bool cross1IsPositive{};
+	//opaque meshes pass when they are not farther, blended ones only when they are closer
+	const auto isBehind{ [blendMode, nearestDepth](float farthestDepth)
+		{
+			return blendMode == BlendMode::opaque ? nearestDepth > farthestDepth : nearestDepth >= farthestDepth;
+		} };
+
+	const int blockIndex{ blockY * m_HiZWidth + blockX };
 
-	if (cross1 > 0)
+	//the stored depth is never closer than the real farthest depth, so it can only reject too little
+	if (isBehind(m_pHiZBufferPixels[blockIndex]))
+		return true;
+
+	if (!m_pHiZIsDirty[blockIndex])
+		return false;
+
+	const int startX{ blockX * m_HiZBlockSize };
+	const int startY{ blockY * m_HiZBlockSize };
+	const int endX{ std::min(startX + m_HiZBlockSize, m_Width) };
+	const int endY{ std::min(startY + m_HiZBlockSize, m_Height) };
+
+	float farthestDepth{};
+	for (int py{ startY }; py < endY; ++py)
 	{
-		cross1IsPositive = true;
+		for (int px{ startX }; px < endX; ++px)
+		{
+			farthestDepth = std::max(farthestDepth, m_pDepthBufferPixels[py * m_Width + px]);
+		}
 	}
 
-	float cross2{ Vector2::Cross(v0 - v2, pixelPos - v2) };
-	bool cross2IsPositive{};
+	m_pHiZBufferPixels[blockIndex] = farthestDepth;
+	m_pHiZIsDirty[blockIndex] = false;
+
+	return isBehind(farthestDepth);
+}
 
-	if (cross2 > 0)
+bool Renderer::SetupTriangle(Triangle& triangle) const
+{
+	const TransformedVertices& vertices{ *triangle.pVertices };
+	const uint32_t indices[3]{ triangle.index0, triangle.index1, triangle.index2 };
+
+	//snap the vertices to the subpixel grid so adjacent triangles agree exactly on their shared edges
+	int64_t x[3]{};
+	int64_t y[3]{};
+	for (int index{}; index < 3; ++index)
 	{
-		cross2IsPositive = true;
+		x[index] = std::llround(vertices.x[indices[index]] * m_SubpixelScale);
+		y[index] = std::llround(vertices.y[indices[index]] * m_SubpixelScale);
 	}
 
-	float cross3{ Vector2::Cross(v1 - v0, pixelPos - v0) };
-	bool cross3IsPositive{};
+	const int64_t doubleArea{ (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]) };
+
+	//the snapping can collapse small triangles
+	if (doubleArea == 0)
+		return false;
+
+	//flip the edges of clockwise triangles so the inside is always positive
+	const int64_t orientation{ doubleArea > 0 ? 1 : -1 };
 
-	if (cross3 > 0)
+	//edge i is the edge opposite to vertex i, Cross(end - start, pixel - start) written out as a * x + b * y + c
+	int amountOfBiasedEdges{};
+	for (int index{}; index < 3; ++index)
 	{
-		cross3IsPositive = true;
+		const int start{ (index + 1) % 3 };
+		const int end{ (index + 2) % 3 };
+		const int64_t edgeX{ x[end] - x[start] };
+		const int64_t edgeY{ y[end] - y[start] };
+
+		EdgeFunction& edge{ triangle.edges[index] };
+		edge.a = orientation * -edgeY;
+		edge.b = orientation * edgeX;
+		edge.c = orientation * (edgeY * x[start] - edgeX * y[start]);
+
+		//top-left rule: a pixel center exactly on an edge only belongs to the triangle if it is a top or a left edge
+		const bool isTopLeftEdge{ edge.a > 0 || (edge.a == 0 && edge.b > 0) };
+		if (!isTopLeftEdge)
+		{
+			edge.c -= 1;
+			++amountOfBiasedEdges;
+		}
 	}
 
-	if (	cross1IsPositive && cross2IsPositive && cross3IsPositive
-		|| !cross1IsPositive && !cross2IsPositive && !cross3IsPositive)
-		return true;
+	//the 3 edge values add up to the double area minus the bias anywhere, a sliver no bigger than its bias
+	//can only cover pixel centers exactly on all 3 edges, where every weight is 0
+	if (orientation * doubleArea <= amountOfBiasedEdges)
+		return false;
 
-	return false;
+	triangle.inverseDoubleArea = 1.f / static_cast<float>(orientation * doubleArea);
+
+	const float depth0{ vertices.z[triangle.index0] };
+	const float depth1{ vertices.z[triangle.index1] };
+	const float depth2{ vertices.z[triangle.index2] };
+
+	triangle.inverseDepths = { 1.f / depth0, 1.f / depth1, 1.f / depth2 };
+
+	//the interpolated depth never gets closer than the closest vertex
+	triangle.nearestDepth = std::min(std::min(depth0, depth1), depth2);
+
+	return true;
 }
 
-void Renderer::CalculateBoundingBox(const Vector2& v0, const Vector2& v1, const Vector2& v2, Vector2& min, Vector2& max)
+//Both lit and unlit materials are scaled by the intensity of the light, so they are equally bright
+static constexpr float g_LightIntensity{ 7.f };
+
+//Phong exponent at full glossiness
+static constexpr float g_Shininess{ 25.f };
+static const SpecularLookupTable g_SpecularLookupTable{ g_Shininess };
+
+//Lambert diffuse + phong specular, the material is packed in 2 textures that are each fetched at most once.
+//With approximate accuracy the specular power comes from the lookup table
+template<Renderer::RenderMode Mode, bool UseNormalMap, MathAccuracy Accuracy>
+struct Renderer::PhongShading
 {
-	min = { std::min(v0.x, v1.x), std::min(v0.y, v1.y) };
-	min.x = std::min(min.x, v2.x);
-	min.x = std::max(min.x, 0.f);
-	min.y = std::min(min.y, v2.y);
-	min.y = std::max(min.y, 0.f);
+	static constexpr MathAccuracy accuracy{ Accuracy };
 
-	max = { std::max(v0.x, v1.x), std::max(v0.y, v1.y) };
-	max.x = std::max(max.x, v2.x);
-	max.x = std::min(max.x, static_cast<float>(m_Width));
-	max.y = std::max(max.y, v2.y);
-	max.y = std::min(max.y, static_cast<float>(m_Height));
-}
+	ColorRGBA operator()(const Material& material, const Vertex_Out& vertex, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode) const
+	{
+		const auto sample{ [&](const Texture* pTexture)
+			{
+				return pTexture->Sample(vertex.uv, uvDdx, uvDdy, filterMode);
+			} };
+
+		float observedArea{};
+		const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
+
+		constexpr bool useSpecular{ Mode == RenderMode::combined || Mode == RenderMode::specular };
+		constexpr bool useDiffuse{ Mode != RenderMode::observedArea };
+
+		ColorRGBA normalSpecular{};
+		if constexpr (UseNormalMap || useSpecular)
+		{
+			normalSpecular = sample(material.pNormalMap);
+		}
+
+		ColorRGBA diffuseGlossiness{};
+		if constexpr (useDiffuse)
+		{
+			diffuseGlossiness = sample(material.pDiffuseMap);
+		}
+
+		const ColorRGBA diffuseColor{ diffuseGlossiness.r, diffuseGlossiness.g, diffuseGlossiness.b };
+		const ColorRGBA specularColor{ normalSpecular.b, normalSpecular.b, normalSpecular.b };
+		const float glossiness{ diffuseGlossiness.a };
+		Vector3 normal{ vertex.normal };
+
+		if constexpr (UseNormalMap)
+		{
+			//remap x and y to range [-1, 1], the normal points out of the surface so z is the positive one that makes it unit length
+			const float x{ 2.f * normalSpecular.r - 1.f };
+			const float y{ 2.f * normalSpecular.g - 1.f };
+			const float z{ std::sqrt(std::max(1.f - x * x - y * y, 0.f)) };
+
+			Vector3 binormal{ Vector3::Cross(vertex.normal, vertex.tangent) };
+			Matrix tangentSpaceAxis{ vertex.tangent, binormal, vertex.normal, Vector3::Zero };
+
+			//transform the sampled normal to tangent space
+			normal = { x, y, z };
+			normal = tangentSpaceAxis.TransformVector(normal).Normalized<Accuracy>();
+		}
+
+		observedArea = std::max(0.f, Vector3::Dot(normal, -lightDirection));
+
+		const auto calculateSpecular{ [&]()
+			{
+				const float cosine{ std::max(Vector3::Dot(2.f * observedArea * normal - -lightDirection, vertex.viewDirection), 0.f) };
+
+				if constexpr (Accuracy == MathAccuracy::approximate)
+					return specularColor * g_SpecularLookupTable.Lookup(cosine, glossiness);
+				else
+					return specularColor * Pow<Accuracy>(cosine, g_Shininess * glossiness);
+			} };
+
+		if constexpr (Mode == RenderMode::combined)
+		{
+			constexpr ColorRGBA ambient{ 0.025f, 0.025f, 0.025f };
+
+			//lambert diffuse
+			ColorRGBA diffuse{ g_LightIntensity * diffuseColor / PI };
 
-void RenderTriangle(const Vector2& v0, const Vector2& v1, const Vector2& v2, Vector2& min, Vector2& max)
+			//specular phong
+			ColorRGBA specular{ calculateSpecular() };
+
+			return (diffuse + specular + ambient) * observedArea;
+		}
+		else if constexpr (Mode == RenderMode::diffuse)
+		{
+			ColorRGBA diffuse{ g_LightIntensity * diffuseColor / PI };
+			return diffuse * observedArea;
+		}
+		else if constexpr (Mode == RenderMode::specular)
+		{
+			ColorRGBA specular{ calculateSpecular() };
+			return specular * observedArea;
+		}
+		else
+		{
+			return { observedArea, observedArea, observedArea };
+		}
+	}
+};
+
+//The diffuse map without lighting, the render modes only show the lighting so they don't change it
+struct Renderer::UnlitShading
+{
+	static constexpr MathAccuracy accuracy{ MathAccuracy::exact };
+
+	ColorRGBA operator()(const Material& material, const Vertex_Out& vertex, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode) const
+	{
+		return g_LightIntensity * material.pDiffuseMap->Sample(vertex.uv, uvDdx, uvDdy, filterMode) / PI;
+	}
+};
+
+struct Renderer::DepthShading
 {
+	static constexpr MathAccuracy accuracy{ MathAccuracy::exact };
 
+	ColorRGBA operator()(const Material&, const Vertex_Out& vertex, const Vector2&, const Vector2&, FilterMode) const
+	{
+		const float value{ Remap(vertex.position.z, 0.995f) };
+		return { value, value, value };
+	}
+};
+
+struct Renderer::DeferredShading
+{
+};
+
+struct Renderer::SampleCaptureShading : UnlitShading
+{
+};
+
+Renderer::ShadingPermutation Renderer::SelectPermutation(const Material& material) const
+{
+	if (material.blendMode == BlendMode::alphaBlend)
+		return material.writesDepth ? SelectPermutation<BlendMode::alphaBlend, true>(material) : SelectPermutation<BlendMode::alphaBlend, false>(material);
+
+	return material.writesDepth ? SelectPermutation<BlendMode::opaque, true>(material) : SelectPermutation<BlendMode::opaque, false>(material);
 }
 
-ColorRGBA Renderer::ShadePixel(const Vertex_Out& vertex, int number) const
+template<BlendMode Blend, bool WritesDepth>
+Renderer::ShadingPermutation Renderer::SelectPermutation(const Material& material) const
 {
+	if (m_pTextureSampleCaptures)
+		return CreatePermutation<SampleCaptureShading, Blend, WritesDepth>();
+
+	//the depth visualization replaces the shading of every material
 	if (m_VisualizeDepthBuffer)
+		return CreatePermutation<DepthShading, Blend, WritesDepth>();
+
+	if (material.shadingModel == ShadingModel::unlit)
+		return CreatePermutation<UnlitShading, Blend, WritesDepth>();
+
+	switch (m_RenderMode)
 	{
-		const float value{ Remap(vertex.position.z, 0.995f) };
-		return {value, value, value};
+	case RenderMode::observedArea:
+		return SelectPhongPermutation<RenderMode::observedArea, Blend, WritesDepth>();
+
+	case RenderMode::diffuse:
+		return SelectPhongPermutation<RenderMode::diffuse, Blend, WritesDepth>();
+
+	case RenderMode::specular:
+		return SelectPhongPermutation<RenderMode::specular, Blend, WritesDepth>();
+
+	case RenderMode::combined:
+	default:
+		return SelectPhongPermutation<RenderMode::combined, Blend, WritesDepth>();
 	}
+}
 
-	float observedArea{};
-	const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
-	constexpr float lightIntensity{ 7.f };
-	constexpr float shininess{ 25.f };
-	Vector3 normal{ vertex.normal };
+template<Renderer::RenderMode Mode, BlendMode Blend, bool WritesDepth>
+Renderer::ShadingPermutation Renderer::SelectPhongPermutation() const
+{
+	switch (m_ShadingAccuracy)
+	{
+	case MathAccuracy::exact:
+		return m_UseNormalMap ? CreatePermutation<PhongShading<Mode, true, MathAccuracy::exact>, Blend, WritesDepth>() : CreatePermutation<PhongShading<Mode, false, MathAccuracy::exact>, Blend, WritesDepth>();
+
+	case MathAccuracy::approximate:
+		return m_UseNormalMap ? CreatePermutation<PhongShading<Mode, true, MathAccuracy::approximate>, Blend, WritesDepth>() : CreatePermutation<PhongShading<Mode, false, MathAccuracy::approximate>, Blend, WritesDepth>();
+
+	case MathAccuracy::fast:
+	default:
+		return m_UseNormalMap ? CreatePermutation<PhongShading<Mode, true, MathAccuracy::fast>, Blend, WritesDepth>() : CreatePermutation<PhongShading<Mode, false, MathAccuracy::fast>, Blend, WritesDepth>();
+	}
+}
+
+template<typename Shading, BlendMode Blend, bool WritesDepth>
+Renderer::ShadingPermutation Renderer::CreatePermutation() const
+{
+	ShadingPermutation permutation{ GetRasterFunction<Shading, Blend, WritesDepth>(), &Renderer::ShadeFragment<Shading, Blend>, Blend, WritesDepth };
 
-	if (m_UseNormalMap)
+	//opaque fragments that write depth are shaded when the tile is resolved, the raster loop only stores their triangle
+	if constexpr (Blend == BlendMode::opaque && WritesDepth)
 	{
-		ColorRGBA sampledNormal{ m_pNormalMap->Sample(vertex.uv) };
+		if (m_UseVisibilityBuffer)
+		{
+			permutation.pRasterize = GetRasterFunction<DeferredShading, Blend, WritesDepth>();
+			permutation.isDeferred = true;
+		}
+	}
 
-		//remap the normal values to range [-1, 1]
-		sampledNormal.r = 2.f * sampledNormal.r - 1.f;
-		sampledNormal.g = 2.f * sampledNormal.g - 1.f;
-		sampledNormal.b = 2.f * sampledNormal.b - 1.f;
-		sampledNormal.a = 2.f * sampledNormal.a - 1.f;
+	return permutation;
+}
 
-		Vector3 binormal{ Vector3::Cross(vertex.normal, vertex.tangent) };
-		Matrix tangentSpaceAxis{ vertex.tangent, binormal, vertex.normal, Vector3::Zero };
+template<typename Shading, BlendMode Blend, bool WritesDepth>
+Renderer::RasterFunction Renderer::GetRasterFunction() const
+{
+	if (m_RasterBackend == RasterBackend::simd && m_SimdWidth == 8)
+		return &Renderer::RenderTriangleAVX2<Shading, Blend, WritesDepth>;
+
+	if (m_RasterBackend == RasterBackend::simd && m_SimdWidth == 4)
+		return &Renderer::RenderTriangleSSE41<Shading, Blend, WritesDepth>;
 
-		//transform the sampledNormal to tangent space
-		normal = { sampledNormal.r, sampledNormal.g, sampledNormal.b };
-		normal = tangentSpaceAxis.TransformVector(normal).Normalized();
+	return &Renderer::RenderTriangleScalar<Shading, Blend, WritesDepth>;
+}
+
+template<typename Shading, BlendMode Blend, bool WritesDepth>
+void Renderer::RenderTriangleScalar(const Triangle& triangle, const Vector2& min, const Vector2& max) const
+{
+	const EdgeFunction& edge0{ triangle.edges[0] };
+	const EdgeFunction& edge1{ triangle.edges[1] };
+	const EdgeFunction& edge2{ triangle.edges[2] };
+
+	const int startX{ static_cast<int>(min.x) };
+	const int startY{ static_cast<int>(min.y) };
+
+	//edge values at the center of the first pixel, stepping a pixel in x adds a and in y adds b
+	const int64_t centerX{ startX * m_SubpixelScale + m_SubpixelScale / 2 };
+	const int64_t centerY{ startY * m_SubpixelScale + m_SubpixelScale / 2 };
+
+	int64_t rowE0{ edge0.a * centerX + edge0.b * centerY + edge0.c };
+	int64_t rowE1{ edge1.a * centerX + edge1.b * centerY + edge1.c };
+	int64_t rowE2{ edge2.a * centerX + edge2.b * centerY + edge2.c };
+
+	const int64_t stepX0{ edge0.a * m_SubpixelScale };
+	const int64_t stepX1{ edge1.a * m_SubpixelScale };
+	const int64_t stepX2{ edge2.a * m_SubpixelScale };
+	const int64_t stepY0{ edge0.b * m_SubpixelScale };
+	const int64_t stepY1{ edge1.b * m_SubpixelScale };
+	const int64_t stepY2{ edge2.b * m_SubpixelScale };
+
+	//walk the rows so the depth and color buffers are touched in memory order
+	for (int py{ startY }; py < max.y; ++py, rowE0 += stepY0, rowE1 += stepY1, rowE2 += stepY2)
+	{
+		int64_t e0{ rowE0 };
+		int64_t e1{ rowE1 };
+		int64_t e2{ rowE2 };
+
+		for (int px{ startX }; px < max.x; ++px, e0 += stepX0, e1 += stepX1, e2 += stepX2)
+		{
+			//the sign bit is set when any of the edges is negative
+			if ((e0 | e1 | e2) < 0)
+				continue;
+
+			PROFILE_COUNT(fragmentsTested, 1);
+
+			const float w0{ static_cast<float>(e0) * triangle.inverseDoubleArea };
+			const float w1{ static_cast<float>(e1) * triangle.inverseDoubleArea };
+			const float w2{ static_cast<float>(e2) * triangle.inverseDoubleArea };
+
+			const float depthInterpolated
+			{
+				1.f / (  w0 * triangle.inverseDepths.x
+					   + w1 * triangle.inverseDepths.y
+					   + w2 * triangle.inverseDepths.z)
+			};
+
+			int pixelIndex{ py * m_Width + px };
+
+			if constexpr (Blend == BlendMode::alphaBlend)
+			{
+				if (depthInterpolated >= m_pDepthBufferPixels[pixelIndex])
+					continue;
+			}
+			else
+			{
+				if (depthInterpolated > m_pDepthBufferPixels[pixelIndex])
+					continue;
+			}
+
+			PROFILE_COUNT(fragmentsPassed, 1);
+
+			if constexpr (WritesDepth)
+			{
+				m_pDepthBufferPixels[pixelIndex] = depthInterpolated;
+			}
+
+			ProcessFragment<Shading, Blend>(triangle, px, py, w0, w1, w2, depthInterpolated);
+		}
 	}
-	
-	observedArea = std::max(0.f, Vector3::Dot(normal, -lightDirection));
+}
 
-	switch (m_RenderMode)
+//Exact int64 to float conversion for values far below 2^51: adding the bits of 1.5 * 2^52 turns the integer into that double plus the value
+TARGET_SSE41 static __m128 ConvertToFloatSSE41(__m128i low, __m128i high)
+{
+	const __m128i magicBits{ _mm_set1_epi64x(0x4338000000000000) };
+	const __m128d magic{ _mm_castsi128_pd(magicBits) };
+
+	const __m128 lowFloats{ _mm_cvtpd_ps(_mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(low, magicBits)), magic)) };
+	const __m128 highFloats{ _mm_cvtpd_ps(_mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(high, magicBits)), magic)) };
+
+	return _mm_movelh_ps(lowFloats, highFloats);
+}
+
+TARGET_SSE41 static __m128 MaskFromBitsSSE41(int bits)
+{
+	const __m128i laneBits{ _mm_setr_epi32(1, 2, 4, 8) };
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), laneBits), laneBits));
+}
+
+TARGET_AVX2 static __m256 ConvertToFloatAVX2(__m256i low, __m256i high)
+{
+	const __m256i magicBits{ _mm256_set1_epi64x(0x4338000000000000) };
+	const __m256d magic{ _mm256_castsi256_pd(magicBits) };
+
+	const __m128 lowFloats{ _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(low, magicBits)), magic)) };
+	const __m128 highFloats{ _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(high, magicBits)), magic)) };
+
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lowFloats), highFloats, 1);
+}
+
+TARGET_AVX2 static __m256 MaskFromBitsAVX2(int bits)
+{
+	const __m256i laneBits{ _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128) };
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), laneBits), laneBits));
+}
+
+template<typename Shading, BlendMode Blend, bool WritesDepth>
+TARGET_SSE41 void Renderer::RenderTriangleSSE41(const Triangle& triangle, const Vector2& min, const Vector2& max) const
+{
+	constexpr int amountOfLanes{ 4 };
+
+	const EdgeFunction& edge0{ triangle.edges[0] };
+	const EdgeFunction& edge1{ triangle.edges[1] };
+	const EdgeFunction& edge2{ triangle.edges[2] };
+
+	const int startX{ static_cast<int>(min.x) };
+	const int startY{ static_cast<int>(min.y) };
+	const int endX{ static_cast<int>(std::ceil(max.x)) };
+	const int endY{ static_cast<int>(std::ceil(max.y)) };
+
+	const int64_t centerX{ startX * m_SubpixelScale + m_SubpixelScale / 2 };
+	const int64_t centerY{ startY * m_SubpixelScale + m_SubpixelScale / 2 };
+
+	int64_t rowE0{ edge0.a * centerX + edge0.b * centerY + edge0.c };
+	int64_t rowE1{ edge1.a * centerX + edge1.b * centerY + edge1.c };
+	int64_t rowE2{ edge2.a * centerX + edge2.b * centerY + edge2.c };
+
+	const int64_t stepX0{ edge0.a * m_SubpixelScale };
+	const int64_t stepX1{ edge1.a * m_SubpixelScale };
+	const int64_t stepX2{ edge2.a * m_SubpixelScale };
+	const int64_t stepY0{ edge0.b * m_SubpixelScale };
+	const int64_t stepY1{ edge1.b * m_SubpixelScale };
+	const int64_t stepY2{ edge2.b * m_SubpixelScale };
+
+	//the edge values are 64 bit, so every span of 4 pixels is split over 2 registers of 2 lanes
+	const __m128i laneOffsetsLow0{ _mm_set_epi64x(stepX0, 0) };
+	const __m128i laneOffsetsLow1{ _mm_set_epi64x(stepX1, 0) };
+	const __m128i laneOffsetsLow2{ _mm_set_epi64x(stepX2, 0) };
+	const __m128i laneOffsetsHigh0{ _mm_set_epi64x(3 * stepX0, 2 * stepX0) };
+	const __m128i laneOffsetsHigh1{ _mm_set_epi64x(3 * stepX1, 2 * stepX1) };
+	const __m128i laneOffsetsHigh2{ _mm_set_epi64x(3 * stepX2, 2 * stepX2) };
+
+	const __m128 one{ _mm_set1_ps(1.f) };
+	const __m128 inverseDoubleArea{ _mm_set1_ps(triangle.inverseDoubleArea) };
+	const __m128 inverseDepth0{ _mm_set1_ps(triangle.inverseDepths.x) };
+	const __m128 inverseDepth1{ _mm_set1_ps(triangle.inverseDepths.y) };
+	const __m128 inverseDepth2{ _mm_set1_ps(triangle.inverseDepths.z) };
+
+	alignas(16) float w0s[amountOfLanes]{};
+	alignas(16) float w1s[amountOfLanes]{};
+	alignas(16) float w2s[amountOfLanes]{};
+	alignas(16) float depths[amountOfLanes]{};
+	alignas(16) float oldDepths[amountOfLanes]{};
+
+	for (int py{ startY }; py < endY; ++py, rowE0 += stepY0, rowE1 += stepY1, rowE2 += stepY2)
 	{
-		case dae::Renderer::RenderMode::combined:
+		float* pDepthRow{ m_pDepthBufferPixels + py * m_Width };
+
+		int64_t spanE0{ rowE0 };
+		int64_t spanE1{ rowE1 };
+		int64_t spanE2{ rowE2 };
+
+		for (int px{ startX }; px < endX; px += amountOfLanes,
+			spanE0 += amountOfLanes * stepX0, spanE1 += amountOfLanes * stepX1, spanE2 += amountOfLanes * stepX2)
 		{
-			constexpr ColorRGBA ambient{ 0.025f, 0.025f, 0.025f };
+			const int amountOfPixels{ std::min(amountOfLanes, endX - px) };
+			const int inBoundsBits{ (1 << amountOfPixels) - 1 };
+
+			const __m128i e0Low{ _mm_add_epi64(_mm_set1_epi64x(spanE0), laneOffsetsLow0) };
+			const __m128i e1Low{ _mm_add_epi64(_mm_set1_epi64x(spanE1), laneOffsetsLow1) };
+			const __m128i e2Low{ _mm_add_epi64(_mm_set1_epi64x(spanE2), laneOffsetsLow2) };
+			const __m128i e0High{ _mm_add_epi64(_mm_set1_epi64x(spanE0), laneOffsetsHigh0) };
+			const __m128i e1High{ _mm_add_epi64(_mm_set1_epi64x(spanE1), laneOffsetsHigh1) };
+			const __m128i e2High{ _mm_add_epi64(_mm_set1_epi64x(spanE2), laneOffsetsHigh2) };
+
+			//the sign bit of a lane is set when any of its edges is negative
+			const int outsideLow{ _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_or_si128(e0Low, e1Low), e2Low))) };
+			const int outsideHigh{ _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_or_si128(e0High, e1High), e2High))) };
+			const int coverageBits{ ~(outsideLow | (outsideHigh << 2)) & inBoundsBits };
+
+			if (coverageBits == 0)
+				continue;
 
-			//lambert diffuse
-			ColorRGBA diffuse{};
-			if (number == 0)
+			PROFILE_COUNT(fragmentsTested, std::popcount(static_cast<unsigned int>(coverageBits)));
+
+			const __m128 w0{ _mm_mul_ps(ConvertToFloatSSE41(e0Low, e0High), inverseDoubleArea) };
+			const __m128 w1{ _mm_mul_ps(ConvertToFloatSSE41(e1Low, e1High), inverseDoubleArea) };
+			const __m128 w2{ _mm_mul_ps(ConvertToFloatSSE41(e2Low, e2High), inverseDoubleArea) };
+			const __m128 depth{ _mm_div_ps(one, _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, inverseDepth0), _mm_mul_ps(w1, inverseDepth1)), _mm_mul_ps(w2, inverseDepth2))) };
+
+			//the lanes past the bounding box belong to another tile, so partial spans go through a copy
+			__m128 oldDepth{};
+			if (amountOfPixels == amountOfLanes)
 			{
-				diffuse = lightIntensity * m_pVehicleDiffuseTexture->Sample(vertex.uv) / PI;
+				oldDepth = _mm_loadu_ps(pDepthRow + px);
 			}
 			else
 			{
-				diffuse = lightIntensity * m_pCombustionEffectDiffuseMap->Sample(vertex.uv) / PI;
-				return diffuse;
+				std::copy_n(pDepthRow + px, amountOfPixels, oldDepths);
+				oldDepth = _mm_load_ps(oldDepths);
 			}
 
-			//specular phong
-			ColorRGBA specular{ m_pSpecularMap->Sample(vertex.uv) * powf(std::max(Vector3::Dot(2.f * std::max(Vector3::Dot(normal, -lightDirection), 0.f) * normal - -lightDirection, vertex.viewDirection), 0.f), shininess * m_pGlossinessMap->Sample(vertex.uv).r) }; //glossinessMap is greyscale so all channels have the same value
+			int passedBits{ coverageBits };
+			if constexpr (Blend == BlendMode::opaque)
+			{
+				passedBits &= _mm_movemask_ps(_mm_cmple_ps(depth, oldDepth));
+			}
+			else
+			{
+				passedBits &= _mm_movemask_ps(_mm_cmplt_ps(depth, oldDepth));
+			}
 
-			return (diffuse + specular + ambient) * observedArea;
+			if constexpr (WritesDepth)
+			{
+				const __m128 newDepth{ _mm_blendv_ps(oldDepth, depth, MaskFromBitsSSE41(passedBits)) };
+				if (amountOfPixels == amountOfLanes)
+				{
+					_mm_storeu_ps(pDepthRow + px, newDepth);
+				}
+				else
+				{
+					_mm_store_ps(oldDepths, newDepth);
+					std::copy_n(oldDepths, amountOfPixels, pDepthRow + px);
+				}
+			}
+
+			if (passedBits == 0)
+				continue;
+
+			PROFILE_COUNT(fragmentsPassed, std::popcount(static_cast<unsigned int>(passedBits)));
+
+			_mm_store_ps(w0s, w0);
+			_mm_store_ps(w1s, w1);
+			_mm_store_ps(w2s, w2);
+			_mm_store_ps(depths, depth);
+
+			for (int lane{}; passedBits != 0; ++lane, passedBits >>= 1)
+			{
+				if (passedBits & 0x01)
+				{
+					ProcessFragment<Shading, Blend>(triangle, px + lane, py, w0s[lane], w1s[lane], w2s[lane], depths[lane]);
+				}
+			}
 		}
-	
-		case dae::Renderer::RenderMode::observedArea:
-			return { observedArea, observedArea, observedArea };
+	}
+}
+
+template<typename Shading, BlendMode Blend, bool WritesDepth>
+TARGET_AVX2 void Renderer::RenderTriangleAVX2(const Triangle& triangle, const Vector2& min, const Vector2& max) const
+{
+	constexpr int amountOfLanes{ 8 };
+
+	const EdgeFunction& edge0{ triangle.edges[0] };
+	const EdgeFunction& edge1{ triangle.edges[1] };
+	const EdgeFunction& edge2{ triangle.edges[2] };
+
+	const int startX{ static_cast<int>(min.x) };
+	const int startY{ static_cast<int>(min.y) };
+	const int endX{ static_cast<int>(std::ceil(max.x)) };
+	const int endY{ static_cast<int>(std::ceil(max.y)) };
+
+	const int64_t centerX{ startX * m_SubpixelScale + m_SubpixelScale / 2 };
+	const int64_t centerY{ startY * m_SubpixelScale + m_SubpixelScale / 2 };
+
+	int64_t rowE0{ edge0.a * centerX + edge0.b * centerY + edge0.c };
+	int64_t rowE1{ edge1.a * centerX + edge1.b * centerY + edge1.c };
+	int64_t rowE2{ edge2.a * centerX + edge2.b * centerY + edge2.c };
+
+	const int64_t stepX0{ edge0.a * m_SubpixelScale };
+	const int64_t stepX1{ edge1.a * m_SubpixelScale };
+	const int64_t stepX2{ edge2.a * m_SubpixelScale };
+	const int64_t stepY0{ edge0.b * m_SubpixelScale };
+	const int64_t stepY1{ edge1.b * m_SubpixelScale };
+	const int64_t stepY2{ edge2.b * m_SubpixelScale };
+
+	//the edge values are 64 bit, so every span of 8 pixels is split over 2 registers of 4 lanes
+	const __m256i laneOffsetsLow0{ _mm256_setr_epi64x(0, stepX0, 2 * stepX0, 3 * stepX0) };
+	const __m256i laneOffsetsLow1{ _mm256_setr_epi64x(0, stepX1, 2 * stepX1, 3 * stepX1) };
+	const __m256i laneOffsetsLow2{ _mm256_setr_epi64x(0, stepX2, 2 * stepX2, 3 * stepX2) };
+	const __m256i laneOffsetsHigh0{ _mm256_add_epi64(laneOffsetsLow0, _mm256_set1_epi64x(4 * stepX0)) };
+	const __m256i laneOffsetsHigh1{ _mm256_add_epi64(laneOffsetsLow1, _mm256_set1_epi64x(4 * stepX1)) };
+	const __m256i laneOffsetsHigh2{ _mm256_add_epi64(laneOffsetsLow2, _mm256_set1_epi64x(4 * stepX2)) };
+
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 inverseDoubleArea{ _mm256_set1_ps(triangle.inverseDoubleArea) };
+	const __m256 inverseDepth0{ _mm256_set1_ps(triangle.inverseDepths.x) };
+	const __m256 inverseDepth1{ _mm256_set1_ps(triangle.inverseDepths.y) };
+	const __m256 inverseDepth2{ _mm256_set1_ps(triangle.inverseDepths.z) };
+
+	alignas(32) float w0s[amountOfLanes]{};
+	alignas(32) float w1s[amountOfLanes]{};
+	alignas(32) float w2s[amountOfLanes]{};
+	alignas(32) float depths[amountOfLanes]{};
+
+	for (int py{ startY }; py < endY; ++py, rowE0 += stepY0, rowE1 += stepY1, rowE2 += stepY2)
+	{
+		float* pDepthRow{ m_pDepthBufferPixels + py * m_Width };
 
-		case dae::Renderer::RenderMode::diffuse:
+		int64_t spanE0{ rowE0 };
+		int64_t spanE1{ rowE1 };
+		int64_t spanE2{ rowE2 };
+
+		for (int px{ startX }; px < endX; px += amountOfLanes,
+			spanE0 += amountOfLanes * stepX0, spanE1 += amountOfLanes * stepX1, spanE2 += amountOfLanes * stepX2)
 		{
-			ColorRGBA diffuse{ lightIntensity * m_pVehicleDiffuseTexture->Sample(vertex.uv) / PI };
-			return diffuse * observedArea;
+			const int amountOfPixels{ std::min(amountOfLanes, endX - px) };
+			const int inBoundsBits{ (1 << amountOfPixels) - 1 };
+
+			const __m256i e0Low{ _mm256_add_epi64(_mm256_set1_epi64x(spanE0), laneOffsetsLow0) };
+			const __m256i e1Low{ _mm256_add_epi64(_mm256_set1_epi64x(spanE1), laneOffsetsLow1) };
+			const __m256i e2Low{ _mm256_add_epi64(_mm256_set1_epi64x(spanE2), laneOffsetsLow2) };
+			const __m256i e0High{ _mm256_add_epi64(_mm256_set1_epi64x(spanE0), laneOffsetsHigh0) };
+			const __m256i e1High{ _mm256_add_epi64(_mm256_set1_epi64x(spanE1), laneOffsetsHigh1) };
+			const __m256i e2High{ _mm256_add_epi64(_mm256_set1_epi64x(spanE2), laneOffsetsHigh2) };
+
+			//the sign bit of a lane is set when any of its edges is negative
+			const int outsideLow{ _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_or_si256(e0Low, e1Low), e2Low))) };
+			const int outsideHigh{ _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_or_si256(e0High, e1High), e2High))) };
+			const int coverageBits{ ~(outsideLow | (outsideHigh << 4)) & inBoundsBits };
+
+			if (coverageBits == 0)
+				continue;
+
+			PROFILE_COUNT(fragmentsTested, std::popcount(static_cast<unsigned int>(coverageBits)));
+
+			const __m256 w0{ _mm256_mul_ps(ConvertToFloatAVX2(e0Low, e0High), inverseDoubleArea) };
+			const __m256 w1{ _mm256_mul_ps(ConvertToFloatAVX2(e1Low, e1High), inverseDoubleArea) };
+			const __m256 w2{ _mm256_mul_ps(ConvertToFloatAVX2(e2Low, e2High), inverseDoubleArea) };
+			const __m256 depth{ _mm256_div_ps(one, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, inverseDepth0), _mm256_mul_ps(w1, inverseDepth1)), _mm256_mul_ps(w2, inverseDepth2))) };
+
+			//lanes past the bounding box belong to another tile and are never loaded or stored
+			const __m256i inBoundsMask{ _mm256_castps_si256(MaskFromBitsAVX2(inBoundsBits)) };
+			const __m256 oldDepth{ _mm256_maskload_ps(pDepthRow + px, inBoundsMask) };
+
+			int passedBits{ coverageBits };
+			if constexpr (Blend == BlendMode::opaque)
+			{
+				passedBits &= _mm256_movemask_ps(_mm256_cmp_ps(depth, oldDepth, _CMP_LE_OQ));
+			}
+			else
+			{
+				passedBits &= _mm256_movemask_ps(_mm256_cmp_ps(depth, oldDepth, _CMP_LT_OQ));
+			}
+
+			if constexpr (WritesDepth)
+			{
+				_mm256_maskstore_ps(pDepthRow + px, inBoundsMask, _mm256_blendv_ps(oldDepth, depth, MaskFromBitsAVX2(passedBits)));
+			}
+
+			if (passedBits == 0)
+				continue;
+
+			PROFILE_COUNT(fragmentsPassed, std::popcount(static_cast<unsigned int>(passedBits)));
+
+			_mm256_store_ps(w0s, w0);
+			_mm256_store_ps(w1s, w1);
+			_mm256_store_ps(w2s, w2);
+			_mm256_store_ps(depths, depth);
+
+			for (int lane{}; passedBits != 0; ++lane, passedBits >>= 1)
+			{
+				if (passedBits & 0x01)
+				{
+					ProcessFragment<Shading, Blend>(triangle, px + lane, py, w0s[lane], w1s[lane], w2s[lane], depths[lane]);
+				}
+			}
 		}
+	}
+}
+
+template<typename Shading, BlendMode Blend>
+void Renderer::ProcessFragment(const Triangle& triangle, int px, int py, float w0, float w1, float w2, float depthInterpolated) const
+{
+	//in visibility buffer mode an opaque fragment only remembers its triangle, the closest one gets shaded once in ResolveVisibilityBuffer
+	if constexpr (std::is_same_v<Shading, DeferredShading>)
+	{
+		m_pVisibilityBufferPixels[px + (py * m_Width)] = static_cast<uint32_t>(&triangle - m_BinnedTriangles.data()) + 1;
+	}
+	else
+	{
+		ShadeFragment<Shading, Blend>(triangle, px, py, w0, w1, w2, depthInterpolated);
+	}
+}
+
+void Renderer::ResolveVisibilityBuffer(int tileIndex) const
+{
+	const int tileX{ tileIndex % m_AmountOfTilesX };
+	const int tileY{ tileIndex / m_AmountOfTilesX };
+
+	const int startX{ tileX * m_TileSize };
+	const int startY{ tileY * m_TileSize };
+	const int endX{ std::min(startX + m_TileSize, m_Width) };
+	const int endY{ std::min(startY + m_TileSize, m_Height) };
 
-		case dae::Renderer::RenderMode::specular:
+	for (int py{ startY }; py < endY; ++py)
+	{
+		for (int px{ startX }; px < endX; ++px)
 		{
-			ColorRGBA specular{ m_pSpecularMap->Sample(vertex.uv) * powf(std::max(Vector3::Dot(2.f * std::max(Vector3::Dot(normal, -lightDirection), 0.f) * normal - -lightDirection, vertex.viewDirection), 0.f), shininess * m_pGlossinessMap->Sample(vertex.uv).r) }; //glossinessMap is greyscale so all channels have the same value
-			return specular * observedArea;
+			const int pixelIndex{ py * m_Width + px };
+			const uint32_t visibility{ m_pVisibilityBufferPixels[pixelIndex] };
+
+			if (visibility == 0)
+				continue;
+
+			m_pVisibilityBufferPixels[pixelIndex] = 0;
+
+			//reconstruct the barycentric weights from the edge functions of the triangle
+			const Triangle& triangle{ m_BinnedTriangles[visibility - 1] };
+			const EdgeFunction& edge0{ triangle.edges[0] };
+			const EdgeFunction& edge1{ triangle.edges[1] };
+			const EdgeFunction& edge2{ triangle.edges[2] };
+
+			const int64_t centerX{ px * m_SubpixelScale + m_SubpixelScale / 2 };
+			const int64_t centerY{ py * m_SubpixelScale + m_SubpixelScale / 2 };
+
+			const float w0{ static_cast<float>(edge0.a * centerX + edge0.b * centerY + edge0.c) * triangle.inverseDoubleArea };
+			const float w1{ static_cast<float>(edge1.a * centerX + edge1.b * centerY + edge1.c) * triangle.inverseDoubleArea };
+			const float w2{ static_cast<float>(edge2.a * centerX + edge2.b * centerY + edge2.c) * triangle.inverseDoubleArea };
+
+			(this->*m_MeshPermutations[triangle.meshIndex].pShade)(triangle, px, py, w0, w1, w2, m_pDepthBufferPixels[pixelIndex]);
+		}
+	}
+}
+
+template<typename Shading, BlendMode Blend>
+void Renderer::ShadeFragment(const Triangle& triangle, int px, int py, float w0, float w1, float w2, float depthInterpolated) const
+{
+	PROFILE_COUNT(fragmentsShaded, 1);
+
+	const TransformedVertices& vertices{ *triangle.pVertices };
+	const uint32_t index0{ triangle.index0 };
+	const uint32_t index1{ triangle.index1 };
+	const uint32_t index2{ triangle.index2 };
+	const Vector2 pixelPos{ static_cast<float>(px), static_cast<float>(py) };
+
+	ColorRGBA finalColor{};
+	Vertex_Out pixel{};
+
+	//perspective correct weights
+	const float perspective0{ w0 * vertices.w[index0] };
+	const float perspective1{ w1 * vertices.w[index1] };
+	const float perspective2{ w2 * vertices.w[index2] };
+	const float interpolatedCameraSpaceZ{ 1.f / (perspective0 + perspective1 + perspective2) };
+
+	const auto interpolate{ [&](const std::vector<float>& stream)
+		{
+			return stream[index0] * perspective0 + stream[index1] * perspective1 + stream[index2] * perspective2;
+		} };
+
+	pixel.uv =
+	{
+		interpolatedCameraSpaceZ * interpolate(vertices.u),
+		interpolatedCameraSpaceZ * interpolate(vertices.v)
+	};
+
+	pixel.position =
+	{
+		pixelPos.x,
+		pixelPos.y,
+		depthInterpolated,
+		interpolatedCameraSpaceZ
+	};
+
+	pixel.normal = Vector3{ interpolate(vertices.normalX), interpolate(vertices.normalY), interpolate(vertices.normalZ) }.Normalized<Shading::accuracy>();
+	pixel.tangent = Vector3{ interpolate(vertices.tangentX), interpolate(vertices.tangentY), interpolate(vertices.tangentZ) }.Normalized<Shading::accuracy>();
+	pixel.viewDirection = { interpolate(vertices.viewDirectionX), interpolate(vertices.viewDirectionY), interpolate(vertices.viewDirectionZ) };
+
+	//the uv one pixel to the right and one pixel down, the same differences a 2x2 quad of pixels gives, they pick the mip level
+	Vector2 uvDdx{};
+	Vector2 uvDdy{};
+	if (m_FilterMode != FilterMode::point)
+	{
+		const auto getUV{ [&](float weight0, float weight1, float weight2)
+			{
+				const float neighbourPerspective0{ weight0 * vertices.w[index0] };
+				const float neighbourPerspective1{ weight1 * vertices.w[index1] };
+				const float neighbourPerspective2{ weight2 * vertices.w[index2] };
+				const float neighbourCameraSpaceZ{ 1.f / (neighbourPerspective0 + neighbourPerspective1 + neighbourPerspective2) };
+
+				return Vector2
+				{
+					neighbourCameraSpaceZ * (vertices.u[index0] * neighbourPerspective0 + vertices.u[index1] * neighbourPerspective1 + vertices.u[index2] * neighbourPerspective2),
+					neighbourCameraSpaceZ * (vertices.v[index0] * neighbourPerspective0 + vertices.v[index1] * neighbourPerspective1 + vertices.v[index2] * neighbourPerspective2)
+				};
+			} };
+
+		//a step of one pixel changes every edge function by a or b times the subpixel scale
+		const float stepScale{ m_SubpixelScale * triangle.inverseDoubleArea };
+		const EdgeFunction* pEdges{ triangle.edges };
+
+		uvDdx = getUV(w0 + pEdges[0].a * stepScale, w1 + pEdges[1].a * stepScale, w2 + pEdges[2].a * stepScale) - pixel.uv;
+		uvDdy = getUV(w0 + pEdges[0].b * stepScale, w1 + pEdges[1].b * stepScale, w2 + pEdges[2].b * stepScale) - pixel.uv;
+	}
+
+	if constexpr (std::is_same_v<Shading, SampleCaptureShading>)
+	{
+		if (triangle.pMaterial->pDiffuseMap == m_pVehicleDiffuseGlossinessMap)
+		{
+			m_pTextureSampleCaptures[(py / m_TileSize) * m_AmountOfTilesX + px / m_TileSize].push_back({ pixel.uv, uvDdx, uvDdy });
 		}
 	}
+
+	finalColor = Shading{}(*triangle.pMaterial, pixel, uvDdx, uvDdy, m_FilterMode);
+
+	if constexpr (Blend == BlendMode::alphaBlend)
+	{
+		const uint32_t backgroundPixel{ m_pBackBufferPixels[px + (py * m_Width)] };
+		const float rValue{ static_cast<float>((backgroundPixel >> m_RedShift) & 0xff) };
+		const float gValue{ static_cast<float>((backgroundPixel >> m_GreenShift) & 0xff) };
+		const float bValue{ static_cast<float>((backgroundPixel >> m_BlueShift) & 0xff) };
+
+		finalColor.a = std::min(1.f, finalColor.a);
+
+		finalColor =
+		{
+			finalColor.a * finalColor.r + (1.f - finalColor.a) * (rValue / 255.f),
+			finalColor.a * finalColor.g + (1.f - finalColor.a) * (gValue / 255.f),
+			finalColor.a * finalColor.b + (1.f - finalColor.a) * (bValue / 255.f)
+		};
+	}
+
+	//Update Color in Buffer
+	finalColor.MaxToOne();
+	
+	m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor);
 }
 
-bool Renderer::SaveBufferToImage() const
+uint32_t Renderer::PackColor(uint8_t red, uint8_t green, uint8_t blue)
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	return (uint32_t{ red } << m_RedShift) | (uint32_t{ green } << m_GreenShift) | (uint32_t{ blue } << m_BlueShift);
+}
+
+uint32_t Renderer::PackColor(const ColorRGBA& color)
+{
+	return PackColor(static_cast<uint8_t>(color.r * 255), static_cast<uint8_t>(color.g * 255), static_cast<uint8_t>(color.b * 255));
+}
+
+void Renderer::CalculateBoundingBox(const Vector2& v0, const Vector2& v1, const Vector2& v2, Vector2& min, Vector2& max)
+{
+	min = { std::min(v0.x, v1.x), std::min(v0.y, v1.y) };
+	min.x = std::min(min.x, v2.x);
+	min.x = std::max(min.x, 0.f);
+	min.y = std::min(min.y, v2.y);
+	min.y = std::max(min.y, 0.f);
+
+	max = { std::max(v0.x, v1.x), std::max(v0.y, v1.y) };
+	max.x = std::max(max.x, v2.x);
+	max.x = std::min(max.x, static_cast<float>(m_Width));
+	max.y = std::max(max.y, v2.y);
+	max.y = std::min(max.y, static_cast<float>(m_Height));
+}
+
+bool Renderer::SaveBufferToImage(const char* pFilePath) const
+{
+	return SDL_SaveBMP(m_pBackBuffer, pFilePath);
 }
 
 void Renderer::ChangeRenderMode()
@@ -1786,6 +2888,241 @@ void Renderer::ChangeRenderMode()
 	}
 }
 
+void Renderer::ChangeRasterBackend()
+{
+	switch (m_RasterBackend)
+	{
+	case RasterBackend::scalar:
+		if (m_SimdWidth == 0)
+		{
+			std::cout << "SIMD raster backend not supported on this cpu\n";
+			return;
+		}
+
+		m_RasterBackend = RasterBackend::simd;
+		std::cout << "Raster backend: SIMD (" << (m_SimdWidth == 8 ? "AVX2" : "SSE4.1") << ")\n";
+		break;
+
+	case RasterBackend::simd:
+		m_RasterBackend = RasterBackend::scalar;
+		std::cout << "Raster backend: scalar\n";
+		break;
+	}
+}
+
+void Renderer::ChangeFilterMode()
+{
+	switch (m_FilterMode)
+	{
+	case FilterMode::point:
+		m_FilterMode = FilterMode::bilinear;
+		std::cout << "Texture filtering: bilinear\n";
+		break;
+
+	case FilterMode::bilinear:
+		m_FilterMode = FilterMode::trilinear;
+		std::cout << "Texture filtering: trilinear\n";
+		break;
+
+	case FilterMode::trilinear:
+		m_FilterMode = FilterMode::point;
+		std::cout << "Texture filtering: point\n";
+		break;
+	}
+}
+
+void Renderer::ChangeShadingAccuracy()
+{
+	switch (m_ShadingAccuracy)
+	{
+	case MathAccuracy::exact:
+		m_ShadingAccuracy = MathAccuracy::fast;
+		std::cout << "Shading math: fast\n";
+		break;
+
+	case MathAccuracy::fast:
+		m_ShadingAccuracy = MathAccuracy::approximate;
+		std::cout << "Shading math: approximate\n";
+		break;
+
+	case MathAccuracy::approximate:
+		m_ShadingAccuracy = MathAccuracy::exact;
+		std::cout << "Shading math: exact\n";
+		break;
+	}
+}
+
+void Renderer::ChangeTextureLayout()
+{
+	switch (m_TextureLayout)
+	{
+	case TextureLayout::linear:
+		m_TextureLayout = TextureLayout::tiled4x4;
+		std::cout << "Texture layout: 4x4 tiles\n";
+		break;
+
+	case TextureLayout::tiled4x4:
+		m_TextureLayout = TextureLayout::tiled8x8;
+		std::cout << "Texture layout: 8x8 tiles\n";
+		break;
+
+	case TextureLayout::tiled8x8:
+		m_TextureLayout = TextureLayout::morton;
+		std::cout << "Texture layout: morton\n";
+		break;
+
+	case TextureLayout::morton:
+		m_TextureLayout = TextureLayout::linear;
+		std::cout << "Texture layout: linear\n";
+		break;
+	}
+
+	for (Texture* pTexture : { m_pCombustionEffectDiffuseMap, m_pVehicleDiffuseGlossinessMap, m_pVehicleNormalSpecularMap })
+	{
+		pTexture->SetLayout(m_TextureLayout);
+	}
+}
+
+//Set associative cache with least recently used replacement, it only counts the lines that miss
+class CacheModel final
+{
+public:
+	//Returns true when the line of the address was not in the cache
+	bool Access(const void* pAddress)
+	{
+		//0 marks an empty way, so the line numbers start at 1
+		const uintptr_t line{ reinterpret_cast<uintptr_t>(pAddress) / m_LineSize + 1 };
+		uintptr_t* pSet{ m_Lines[line % m_AmountOfSets] };
+
+		//every set is ordered from most to least recently used
+		for (int way{}; way < m_AmountOfWays; ++way)
+		{
+			if (pSet[way] == line)
+			{
+				std::rotate(pSet, pSet + way, pSet + way + 1);
+				return false;
+			}
+		}
+
+		std::rotate(pSet, pSet + m_AmountOfWays - 1, pSet + m_AmountOfWays);
+		pSet[0] = line;
+		return true;
+	}
+
+private:
+	//32 KiB, the size of a typical L1 data cache
+	static constexpr int m_LineSize{ 64 };
+	static constexpr int m_AmountOfSets{ 64 };
+	static constexpr int m_AmountOfWays{ 8 };
+
+	uintptr_t m_Lines[m_AmountOfSets][m_AmountOfWays]{};
+};
+
+void Renderer::RunTextureLayoutBenchmark()
+{
+	//capture the samples the vehicle takes from its diffuse texture over a full turn, the tiles are joined in the order a thread renders them
+	constexpr int amountOfAngles{ 16 };
+	std::vector<std::vector<TextureSample>> tileCaptures(m_TileIndices.size());
+	std::vector<TextureSample> samples{};
+
+	//the benchmark can run before the first Update
+	m_Camera.CalculateViewMatrix();
+	m_Camera.CalculateProjectionMatrix();
+
+	const FilterMode filterMode{ m_FilterMode };
+	const Matrix worldMatrices[2]{ m_MeshesWorld[0].worldMatrix, m_MeshesWorld[1].worldMatrix };
+	m_FilterMode = FilterMode::trilinear;
+	m_pTextureSampleCaptures = tileCaptures.data();
+
+	for (int angleIndex{}; angleIndex < amountOfAngles; ++angleIndex)
+	{
+		const float angle{ angleIndex * PI_2 / amountOfAngles };
+		for (Mesh& mesh : m_MeshesWorld)
+		{
+			mesh.worldMatrix = Matrix::CreateRotationY(angle) * Matrix::CreateTranslation(mesh.worldMatrix.GetTranslation());
+		}
+
+		Render();
+
+		for (std::vector<TextureSample>& tileCapture : tileCaptures)
+		{
+			samples.insert(samples.end(), tileCapture.begin(), tileCapture.end());
+			tileCapture.clear();
+		}
+	}
+
+	m_pTextureSampleCaptures = nullptr;
+	m_FilterMode = filterMode;
+	m_MeshesWorld[0].worldMatrix = worldMatrices[0];
+	m_MeshesWorld[1].worldMatrix = worldMatrices[1];
+
+	std::cout << "\nTexture layout benchmark: " << samples.size() << " trilinear samples of the vehicle diffuse texture over " << amountOfAngles << " angles\n";
+
+	const std::pair<TextureLayout, const char*> layouts[]
+	{
+		{ TextureLayout::linear, "linear" },
+		{ TextureLayout::tiled4x4, "4x4 tiles" },
+		{ TextureLayout::tiled8x8, "8x8 tiles" },
+		{ TextureLayout::morton, "morton" }
+	};
+
+	uint64_t linearMisses{};
+	std::vector<const uint32_t*> footprint{};
+
+	for (const auto& [layout, pName] : layouts)
+	{
+		m_pVehicleDiffuseGlossinessMap->SetLayout(layout);
+
+		//replay the addresses of every texel the samples read through the cache model
+		CacheModel cache{};
+		uint64_t accesses{};
+		uint64_t misses{};
+		for (const TextureSample& sample : samples)
+		{
+			footprint.clear();
+			m_pVehicleDiffuseGlossinessMap->GetFootprint(sample.uv, sample.uvDdx, sample.uvDdy, FilterMode::trilinear, footprint);
+
+			for (const uint32_t* pTexel : footprint)
+			{
+				++accesses;
+				misses += cache.Access(pTexel);
+			}
+		}
+
+		if (layout == TextureLayout::linear)
+		{
+			linearMisses = misses;
+		}
+
+		//and time the real samples, the best run is the one with the least noise.
+		//The sum of the samples is printed, so the loop can't be optimized away, and is the same for every layout
+		float bestTime{ INFINITY };
+		float sum{};
+		for (int run{}; run < 5; ++run)
+		{
+			sum = 0.f;
+			const auto start{ std::chrono::steady_clock::now() };
+			{
+				PROFILE_ZONE("Texture sampling");
+				for (const TextureSample& sample : samples)
+				{
+					sum += m_pVehicleDiffuseGlossinessMap->Sample(sample.uv, sample.uvDdx, sample.uvDdy, FilterMode::trilinear).r;
+				}
+			}
+			const std::chrono::duration<float, std::milli> duration{ std::chrono::steady_clock::now() - start };
+
+			bestTime = std::min(bestTime, duration.count());
+		}
+
+		const float missRate{ accesses > 0 ? 100.f * misses / accesses : 0.f };
+		const float missReduction{ linearMisses > 0 ? 100.f * (1.f - static_cast<float>(misses) / linearMisses) : 0.f };
+		std::cout << pName << ": " << misses << " cache line misses (" << missRate << "% of texel reads, "
+			<< missReduction << "% fewer than linear), " << bestTime << " ms, sum of the samples " << sum << "\n";
+	}
+
+	m_pVehicleDiffuseGlossinessMap->SetLayout(m_TextureLayout);
+}
+
 void Renderer::SetIsRotating(bool isRotating)
 {
 	m_IsRotating = isRotating;
@@ -1814,4 +3151,14 @@ void Renderer::SetVisualizeDepthBuffer(bool visualizeDepthBuffer)
 bool Renderer::GetVisualizeDepthBuffer() const
 {
 	return m_VisualizeDepthBuffer;
+}
+
+void Renderer::SetUseVisibilityBuffer(bool useVisibilityBuffer)
+{
+	m_UseVisibilityBuffer = useVisibilityBuffer;
+}
+
+bool Renderer::GetUseVisibilityBuffer() const
+{
+	return m_UseVisibilityBuffer;
 }
\ No newline at end of file
@@ -21,6 +21,8 @@ namespace dae
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
+		//Headless, renders into an owned buffer without a window or video subsystem
+		Renderer(int width, int height);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -31,9 +33,40 @@ namespace dae
 		void Update(Timer* pTimer);
 		void Render();
 
-		bool SaveBufferToImage() const;
+		//Places the camera and turns the meshes like the keyframe, instead of following the input like Update
+		void ApplyCameraKeyframe(const CameraKeyframe& keyframe);
+
+		//Wall clock time in milliseconds the stages of the last frame took, and how much work the Hi-Z buffer saved it
+		struct FrameStatistics
+		{
+			double clear{};
+			double vertex{}; //transforming, clipping, setting up and binning the triangles
+			double raster{}; //the tiles, including the shading of the fragments that don't go to the visibility buffer
+			double shade{}; //resolving the visibility buffer
+			double present{};
+			int hiZRejectedBlocks{}; //triangle and 8x8 block pairs that were skipped because the triangle is behind the block
+		};
+		const FrameStatistics& GetFrameStatistics() const;
+
+		//Returns true when the bmp could not be saved
+		bool SaveBufferToImage(const char* pFilePath = "Rasterizer_ColorBuffer.bmp") const;
+
+		enum class RenderMode
+		{
+			combined,
+			observedArea,
+			diffuse, //(incl. observed area)
+			specular //(incl. observed area)
+		};
 
 		void ChangeRenderMode();
+		void ChangeRasterBackend();
+		void ChangeFilterMode();
+		void ChangeShadingAccuracy();
+		void ChangeTextureLayout();
+
+		//Renders the vehicle over a full turn and compares how every texture layout does on its diffuse samples
+		void RunTextureLayoutBenchmark();
 
 		void SetIsRotating(bool isRotating);
 		bool GetIsRotating() const;
@@ -44,45 +77,145 @@ namespace dae
 		void SetVisualizeDepthBuffer(bool visualizeDepthBuffer);
 		bool GetVisualizeDepthBuffer() const;
 
+		void SetUseVisibilityBuffer(bool useVisibilityBuffer);
+		bool GetUseVisibilityBuffer() const;
+
 	private:
-		SDL_Window* m_pWindow{};
+		SDL_Window* m_pWindow{}; //nullptr when headless
 
 		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
+		SDL_Surface* m_pBackBuffer{ nullptr }; //the front buffer itself when the window surface is XRGB8888
 		uint32_t* m_pBackBufferPixels{};
+		uint32_t* m_pOwnedColorBufferPixels{}; //the pixels of the back buffer when it is not the window surface
+
+		//the color buffer is always XRGB8888, so the pixels are packed without looking up the surface format
+		static constexpr int m_RedShift{ 16 };
+		static constexpr int m_GreenShift{ 8 };
+		static constexpr int m_BlueShift{ 0 };
 
 		float* m_pDepthBufferPixels{};
 
+		//index + 1 in m_BinnedTriangles of the closest opaque triangle per pixel, 0 when the pixel is empty
+		uint32_t* m_pVisibilityBufferPixels{};
+
 		Camera m_Camera{};
 
 		int m_Width{};
 		int m_Height{};
 
 		Texture* m_pCombustionEffectDiffuseMap{};
-		Texture* m_pVehicleDiffuseTexture{};
-		Texture* m_pNormalMap{};
-		Texture* m_pSpecularMap{};
-		Texture* m_pGlossinessMap{};
+		Texture* m_pVehicleDiffuseGlossinessMap{}; //diffuse rgb + glossiness in alpha
+		Texture* m_pVehicleNormalSpecularMap{}; //normal xy + specular intensity in blue
 
 		std::vector<Mesh> m_MeshesWorld{};
 
 		bool m_IsRotating{ true };
 		bool m_UseNormalMap{ true };
 		bool m_VisualizeDepthBuffer{ false };
+		bool m_UseVisibilityBuffer{ false };
 
-		enum class RenderMode
+		//Shading functors, the raster loops are instantiated per functor so the shading of a fragment is inlined
+		template<RenderMode Mode, bool UseNormalMap, MathAccuracy Accuracy> struct PhongShading;
+		struct UnlitShading;
+		struct DepthShading; //visualizes the depth buffer for every material
+		struct DeferredShading; //opaque fragments only store their triangle, they are shaded when the visibility buffer is resolved
+		struct SampleCaptureShading; //unlit, records the texture samples of the vehicle for the texture layout benchmark
+
+		RenderMode m_RenderMode{ RenderMode::combined };
+
+		enum class RasterBackend
 		{
-			combined,
-			observedArea,
-			diffuse, //(incl. observed area)
-			specular //(incl. observed area)
+			scalar,
+			simd //8 pixels at once with AVX2, 4 with SSE4.1
 		};
-		int random{};
-		RenderMode m_RenderMode{ RenderMode::combined };
+		RasterBackend m_RasterBackend{ RasterBackend::scalar };
+		int m_SimdWidth{}; //detected at runtime, 0 when the cpu has no AVX2 or SSE4.1
+
+		FilterMode m_FilterMode{ FilterMode::trilinear };
+		MathAccuracy m_ShadingAccuracy{ MathAccuracy::fast }; //of the normalizations and the specular power
+		TextureLayout m_TextureLayout{ TextureLayout::linear };
+
+		//uv and derivatives of a vehicle fragment, captured by the texture layout benchmark
+		struct TextureSample
+		{
+			Vector2 uv{};
+			Vector2 uvDdx{};
+			Vector2 uvDdy{};
+		};
+		std::vector<TextureSample>* m_pTextureSampleCaptures{}; //one vector per tile so the tiles can capture in parallel, nullptr when not capturing.
+		//Every mesh is shaded with SampleCaptureShading while it is set, so no other permutation checks it
+
+		//vertices are snapped to 28.4 fixed point, pixels are sampled at their center
+		static constexpr int64_t m_SubpixelScale{ 16 };
+
+		//e(x, y) = a * x + b * y + c in fixed point, not negative on the inside of the triangle (top-left rule included)
+		struct EdgeFunction
+		{
+			int64_t a{};
+			int64_t b{};
+			int64_t c{};
+		};
+
+		//Screen space triangle that survived culling, ready to be rasterized by the tiles it overlaps
+		struct Triangle
+		{
+			const TransformedVertices* pVertices{};
+			uint32_t index0{};
+			uint32_t index1{};
+			uint32_t index2{};
+			Vector2 min{};
+			Vector2 max{};
+			float area{};
+			int meshIndex{};
+			const Material* pMaterial{};
+
+			//triangle setup, done once so the raster loop only has to add constants per pixel
+			EdgeFunction edges[3]{};
+			float inverseDoubleArea{};
+			Vector3 inverseDepths{};
+			float nearestDepth{};
+		};
+
+		static constexpr int m_TileSize{ 64 };
+		int m_AmountOfTilesX{};
+		int m_AmountOfTilesY{};
+		std::vector<Triangle> m_BinnedTriangles{};
+		std::vector<std::vector<int>> m_TileBins{}; //per tile the indices in m_BinnedTriangles, in submission order
+		std::vector<int> m_TileIndices{};
+
+		//The raster and shading functions of one permutation, picked per mesh once per frame so the loops don't branch on the modes per pixel
+		using RasterFunction = void (Renderer::*)(const Triangle& triangle, const Vector2& min, const Vector2& max) const;
+		using ShadeFunction = void (Renderer::*)(const Triangle& triangle, int px, int py, float w0, float w1, float w2, float depthInterpolated) const;
+		struct ShadingPermutation
+		{
+			RasterFunction pRasterize{};
+			ShadeFunction pShade{}; //also used to resolve the visibility buffer
+			BlendMode blendMode{};
+			bool writesDepth{};
+			bool isDeferred{}; //the fragments go to the visibility buffer
+		};
+		std::vector<ShadingPermutation> m_MeshPermutations{}; //per mesh
+
+		//Hi-Z: the farthest depth of every 8x8 block of the depth buffer, lets triangles hidden behind it skip the whole block
+		static constexpr int m_HiZBlockSize{ 8 };
+		static_assert(m_TileSize % m_HiZBlockSize == 0 && m_TileSize / m_HiZBlockSize <= 8, "a tile has to hold at most 8x8 whole Hi-Z blocks");
+		int m_HiZWidth{};
+		int m_HiZHeight{};
+		float* m_pHiZBufferPixels{};
+		bool* m_pHiZIsDirty{}; //depth was written in the block since its farthest depth was last calculated
+
+		//the tiles run in parallel, the time the threads spent on every tile splits the wall clock time of the tiles in raster and shade
+		FrameStatistics m_FrameStatistics{};
+		double* m_pTileRenderTimes{};
+		double* m_pTileShadeTimes{};
+
+		void CreateOwnedBackBuffer();
+		void Initialize();
 
 		//Function that transforms the vertices from the mesh from World space to Screen space
 		void VertexTransformationFunction(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const;
 		void VertexTransformationFunction(std::vector<Mesh>& meshes_world);
+		void ClipTriangle(Mesh& mesh, const Matrix& worldViewProjectionMatrix, uint32_t index0, uint32_t index1, uint32_t index2) const;
 		void W1_Part1() const;
 		void W1_Part2() const;
 		void W1_Part3() const;
@@ -97,10 +230,27 @@ namespace dae
 		void W3_Part2();
 
 		void W4_Part1();
+		//Culls and sets up the transformed triangles and adds them to the bins of the tiles they overlap
+		void BinTriangles();
+
+		ShadingPermutation SelectPermutation(const Material& material) const;
+		template<BlendMode Blend, bool WritesDepth> ShadingPermutation SelectPermutation(const Material& material) const;
+		template<RenderMode Mode, BlendMode Blend, bool WritesDepth> ShadingPermutation SelectPhongPermutation() const;
+		template<typename Shading, BlendMode Blend, bool WritesDepth> ShadingPermutation CreatePermutation() const;
+		template<typename Shading, BlendMode Blend, bool WritesDepth> RasterFunction GetRasterFunction() const;
+
+		static uint32_t PackColor(uint8_t red, uint8_t green, uint8_t blue);
+		static uint32_t PackColor(const ColorRGBA& color);
 
-		bool IsPixelInTriange(const Vector2& v0, const Vector2& v1, const Vector2& v2, const Vector2& pixelPos) const;
+		bool SetupTriangle(Triangle& triangle) const;
 		void CalculateBoundingBox(const Vector2& v0, const Vector2& v1, const Vector2& v2, Vector2& min, Vector2& max);
-		void RenderTriangle(const Vector2& v0, const Vector2& v1, const Vector2& v2, Vector2& min, Vector2& max);
-		ColorRGBA ShadePixel(const Vertex_Out& vertex, int number) const;
+		int RenderTile(int tileIndex) const;
+		bool IsBlockOccluded(int blockX, int blockY, float nearestDepth, BlendMode blendMode) const;
+		template<typename Shading, BlendMode Blend, bool WritesDepth> void RenderTriangleScalar(const Triangle& triangle, const Vector2& min, const Vector2& max) const;
+		template<typename Shading, BlendMode Blend, bool WritesDepth> void RenderTriangleSSE41(const Triangle& triangle, const Vector2& min, const Vector2& max) const;
+		template<typename Shading, BlendMode Blend, bool WritesDepth> void RenderTriangleAVX2(const Triangle& triangle, const Vector2& min, const Vector2& max) const;
+		template<typename Shading, BlendMode Blend> void ProcessFragment(const Triangle& triangle, int px, int py, float w0, float w1, float w2, float depthInterpolated) const;
+		void ResolveVisibilityBuffer(int tileIndex) const;
+		template<typename Shading, BlendMode Blend> void ShadeFragment(const Triangle& triangle, int px, int py, float w0, float w1, float w2, float depthInterpolated) const;
 	};
 }
\ No newline at end of file
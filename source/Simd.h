@@ -0,0 +1,59 @@
+#pragma once
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//MSVC lets every function use any instruction set, gcc and clang need to be told per function
+#if defined(_MSC_VER)
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace dae
+{
+	//Returns how many floats the widest instruction set this cpu supports processes at once, 0 when there is no SSE4.1
+	inline int DetectSimdWidth()
+	{
+#if defined(_MSC_VER)
+		int cpuInfo[4]{};
+		__cpuid(cpuInfo, 0);
+		const int highestFunctionId{ cpuInfo[0] };
+
+		__cpuid(cpuInfo, 1);
+		const bool hasSse41{ (cpuInfo[2] & (1 << 19)) != 0 };
+		const bool hasOsxsave{ (cpuInfo[2] & (1 << 27)) != 0 };
+		const bool hasAvx{ (cpuInfo[2] & (1 << 28)) != 0 };
+
+		//the os also has to save the ymm registers on a context switch
+		bool hasAvx2{};
+		if (highestFunctionId >= 7 && hasAvx && hasOsxsave && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(cpuInfo, 7, 0);
+			hasAvx2 = (cpuInfo[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		const bool hasSse41{ __builtin_cpu_supports("sse4.1") != 0 };
+		const bool hasAvx2{ __builtin_cpu_supports("avx2") != 0 };
+#endif
+
+		if (hasAvx2)
+			return 8;
+
+		if (hasSse41)
+			return 4;
+
+		return 0;
+	}
+
+	//The cpu doesn't change while running, so it is only asked once
+	inline int GetSimdWidth()
+	{
+		static const int simdWidth{ DetectSimdWidth() };
+		return simdWidth;
+	}
+}
@@ -1,39 +1,625 @@
 #include "Texture.h"
+#include "BlockCompression.h"
 #include "Vector2.h"
+#include "Profiler.h"
 #include <SDL_image.h>
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 namespace dae
 {
+	static std::atomic<uint64_t> g_NextTextureId{ 1 };
+
 	Texture::Texture(SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+		m_Id(g_NextTextureId++)
 	{
+		//decode to the packed format once, rows are pitch bytes apart and a pixel can be 1 to 4 bytes
+		MipLevel fullResolution{ pSurface->w, pSurface->h };
+		fullResolution.texels.resize(static_cast<size_t>(pSurface->w) * pSurface->h);
+
+		const int bytesPerPixel{ pSurface->format->BytesPerPixel };
+		for (int y{}; y < pSurface->h; ++y)
+		{
+			const Uint8* pRow{ static_cast<const Uint8*>(pSurface->pixels) + y * pSurface->pitch };
+
+			for (int x{}; x < pSurface->w; ++x)
+			{
+				Uint32 pixel{};
+				std::memcpy(&pixel, pRow + x * bytesPerPixel, bytesPerPixel);
+
+				Uint8 rValue{}, gValue{}, bValue{}, alphaValue{};
+				SDL_GetRGBA(pixel, pSurface->format, &rValue, &gValue, &bValue, &alphaValue);
+
+				fullResolution.texels[y * pSurface->w + x] = rValue | gValue << 8 | bValue << 16 | static_cast<uint32_t>(alphaValue) << 24;
+			}
+		}
+
+		SDL_FreeSurface(pSurface);
+
+		m_MipLevels.push_back(std::move(fullResolution));
+		GenerateMipLevels();
+	}
+
+	Texture::Texture(MipLevel&& fullResolution) :
+		m_Id(g_NextTextureId++)
+	{
+		m_MipLevels.push_back(std::move(fullResolution));
+		GenerateMipLevels();
 	}
 
-	Texture::~Texture()
+	Texture::Texture(TextureFormat format, std::vector<MipLevel>&& mipLevels) :
+		m_MipLevels(std::move(mipLevels)),
+		m_Format(format),
+		m_Id(g_NextTextureId++)
 	{
-		if (m_pSurface)
+	}
+
+	Texture* Texture::LoadFromFile(const std::string& path, TextureLayout layout)
+	{
+		//the block compressed containers are read as they are, everything else goes through SDL_image
+		std::string extension{ path.substr(std::min(path.find_last_of('.'), path.size())) };
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char character) { return static_cast<char>(std::tolower(static_cast<unsigned char>(character))); });
+
+		if (extension == ".dds" || extension == ".ktx")
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			std::ifstream stream{ path, std::ios::binary };
+			if (!stream)
+				return nullptr;
+
+			const std::vector<uint8_t> file{ std::istreambuf_iterator<char>{ stream }, std::istreambuf_iterator<char>{} };
+			return extension == ".dds" ? LoadDDS(file) : LoadKTX(file);
 		}
+
+		auto surface{ IMG_Load(path.c_str()) };
+		Texture* pTexture{ new Texture(surface) };
+		pTexture->SetLayout(layout);
+		return pTexture;
 	}
 
-	Texture* Texture::LoadFromFile(const std::string& path)
+	//Little endian 32 bit value at offset, the caller checks the size of the file
+	static uint32_t ReadUint32(const std::vector<uint8_t>& file, size_t offset)
 	{
-		auto surface{ IMG_Load(path.c_str()) };
-		return new Texture(surface);
+		return file[offset] | file[offset + 1] << 8 | file[offset + 2] << 16 | static_cast<uint32_t>(file[offset + 3]) << 24;
+	}
+
+	static constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<uint8_t>(a) | static_cast<uint8_t>(b) << 8 | static_cast<uint8_t>(c) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24;
+	}
+
+	static size_t GetBlockSize(TextureFormat format)
+	{
+		return format == TextureFormat::bc1 ? 8 : 16;
+	}
+
+	static size_t GetLevelSize(TextureFormat format, int width, int height)
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+	}
+
+	Texture* Texture::LoadDDS(const std::vector<uint8_t>& file)
+	{
+		//"DDS " + 124 byte header, the pixel format starts at 76 and a "DX10" four cc adds a 20 byte header with the dxgi format
+		constexpr size_t headerSize{ 128 };
+		constexpr size_t extendedHeaderSize{ 20 };
+		if (file.size() < headerSize || ReadUint32(file, 0) != MakeFourCC('D', 'D', 'S', ' '))
+			return nullptr;
+
+		const int height{ static_cast<int>(ReadUint32(file, 12)) };
+		const int width{ static_cast<int>(ReadUint32(file, 16)) };
+		const int amountOfLevels{ std::max(static_cast<int>(ReadUint32(file, 28)), 1) };
+		const uint32_t fourCC{ ReadUint32(file, 84) };
+
+		TextureFormat format{};
+		size_t offset{ headerSize };
+		if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+		{
+			format = TextureFormat::bc1;
+		}
+		else if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+		{
+			format = TextureFormat::bc3;
+		}
+		else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+		{
+			format = TextureFormat::bc5;
+		}
+		else if (fourCC == MakeFourCC('D', 'X', '1', '0') && file.size() >= headerSize + extendedHeaderSize)
+		{
+			offset += extendedHeaderSize;
+
+			//typeless, unorm and srgb variants, the colors are used as they are
+			switch (ReadUint32(file, headerSize))
+			{
+			case 70: case 71: case 72:
+				format = TextureFormat::bc1;
+				break;
+
+			case 76: case 77: case 78:
+				format = TextureFormat::bc3;
+				break;
+
+			case 82: case 83:
+				format = TextureFormat::bc5;
+				break;
+
+			default:
+				return nullptr;
+			}
+		}
+		else
+		{
+			return nullptr;
+		}
+
+		//the levels follow each other without padding
+		std::vector<const uint8_t*> levelData{};
+		for (int levelIndex{}; levelIndex < amountOfLevels; ++levelIndex)
+		{
+			const size_t levelSize{ GetLevelSize(format, std::max(width >> levelIndex, 1), std::max(height >> levelIndex, 1)) };
+			if (offset + levelSize > file.size())
+				break;
+
+			levelData.push_back(file.data() + offset);
+			offset += levelSize;
+		}
+
+		return CreateBlockCompressed(format, width, height, levelData);
+	}
+
+	Texture* Texture::LoadKTX(const std::vector<uint8_t>& file)
+	{
+		//KTX 1.1: 12 byte identifier + 13 values, the key/value data and then every level as its size and its data padded to 4 bytes
+		constexpr uint8_t identifier[12]{ 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+		constexpr size_t headerSize{ 64 };
+		if (file.size() < headerSize || std::memcmp(file.data(), identifier, sizeof(identifier)) != 0 || ReadUint32(file, 12) != 0x04030201)
+			return nullptr;
+
+		TextureFormat format{};
+		switch (ReadUint32(file, 28))
+		{
+		case 0x83F0: case 0x83F1: case 0x8C4C: case 0x8C4D: //GL_COMPRESSED_RGB(A)_S3TC_DXT1_EXT and the srgb variants
+			format = TextureFormat::bc1;
+			break;
+
+		case 0x83F3: case 0x8C4F: //GL_COMPRESSED_RGBA_S3TC_DXT5_EXT and the srgb variant
+			format = TextureFormat::bc3;
+			break;
+
+		case 0x8DBD: //GL_COMPRESSED_RG_RGTC2
+			format = TextureFormat::bc5;
+			break;
+
+		default:
+			return nullptr;
+		}
+
+		const int width{ static_cast<int>(ReadUint32(file, 36)) };
+		const int height{ std::max(static_cast<int>(ReadUint32(file, 40)), 1) };
+		const int amountOfLevels{ std::max(static_cast<int>(ReadUint32(file, 56)), 1) };
+		size_t offset{ headerSize + ReadUint32(file, 60) };
+
+		std::vector<const uint8_t*> levelData{};
+		for (int levelIndex{}; levelIndex < amountOfLevels; ++levelIndex)
+		{
+			if (offset + 4 > file.size())
+				break;
+
+			const size_t levelSize{ GetLevelSize(format, std::max(width >> levelIndex, 1), std::max(height >> levelIndex, 1)) };
+			const size_t imageSize{ ReadUint32(file, offset) };
+			offset += 4;
+			if (imageSize < levelSize || offset + levelSize > file.size())
+				break;
+
+			levelData.push_back(file.data() + offset);
+			offset += (imageSize + 3) & ~size_t{ 3 };
+		}
+
+		return CreateBlockCompressed(format, width, height, levelData);
+	}
+
+	Texture* Texture::CreateBlockCompressed(TextureFormat format, int width, int height, const std::vector<const uint8_t*>& levelData)
+	{
+		if (width <= 0 || height <= 0 || levelData.empty())
+			return nullptr;
+
+		std::vector<MipLevel> mipLevels(levelData.size());
+		for (size_t levelIndex{}; levelIndex < levelData.size(); ++levelIndex)
+		{
+			MipLevel& level{ mipLevels[levelIndex] };
+			level.width = std::max(width >> levelIndex, 1);
+			level.height = std::max(height >> levelIndex, 1);
+			level.blockShift = 2;
+			level.blocksPerRow = (level.width + 3) / 4;
+
+			const size_t levelSize{ GetLevelSize(format, level.width, level.height) };
+			level.texels.resize(levelSize / sizeof(uint32_t));
+			std::memcpy(level.texels.data(), levelData[levelIndex], levelSize);
+		}
+
+		return new Texture(format, std::move(mipLevels));
 	}
 
-	ColorRGBA Texture::Sample(const Vector2& uv)
+	Texture* Texture::Pack(const Texture& first, const Texture& second, uint32_t(*combine)(uint32_t first, uint32_t second))
 	{
-		const Vector2 scaledUV{ std::clamp(uv.x, 0.f, 1.f) * m_pSurface->w, std::clamp(uv.y, 0.f, 1.f) * m_pSurface->h};
+		const MipLevel& firstLevel{ first.m_MipLevels.front() };
+		const MipLevel& secondLevel{ second.m_MipLevels.front() };
+		assert(firstLevel.width == secondLevel.width && firstLevel.height == secondLevel.height && "packed maps need the same size");
 
-		Uint32 pixel{ m_pSurfacePixels[static_cast<int>(scaledUV.y) * m_pSurface->h + static_cast<int>(scaledUV.x)] };
+		//the mip chain is built again from the packed texels, it has to start out in rows
+		MipLevel fullResolution{ firstLevel.width, firstLevel.height };
+		fullResolution.texels.resize(static_cast<size_t>(firstLevel.width) * firstLevel.height);
+
+		for (int y{}; y < firstLevel.height; ++y)
+		{
+			for (int x{}; x < firstLevel.width; ++x)
+			{
+				fullResolution.texels[y * firstLevel.width + x] = combine(first.FetchTexel(firstLevel, x, y), second.FetchTexel(secondLevel, x, y));
+			}
+		}
+
+		//the packed texture is rgba8, so it gets a full mip chain even when a map was block compressed
+		Texture* pTexture{ new Texture(std::move(fullResolution)) };
+		pTexture->SetLayout(first.m_Layout);
+		return pTexture;
+	}
+
+	Texture* Texture::PackDiffuseGlossiness(const Texture& diffuse, const Texture& glossiness)
+	{
+		//the glossiness map is grey, its red channel is the glossiness
+		return Pack(diffuse, glossiness, [](uint32_t diffuseTexel, uint32_t glossinessTexel)
+			{
+				return (diffuseTexel & 0x00ffffff) | (glossinessTexel & 0xff) << 24;
+			});
+	}
+
+	Texture* Texture::PackNormalSpecular(const Texture& normal, const Texture& specular)
+	{
+		return Pack(normal, specular, [](uint32_t normalTexel, uint32_t specularTexel)
+			{
+				//one channel is left for the specular map, a tinted map keeps its luminance (Rec. 709 weights in 8 bit fixed point)
+				const uint32_t luminance{ (54 * (specularTexel & 0xff) + 183 * ((specularTexel >> 8) & 0xff) + 19 * ((specularTexel >> 16) & 0xff) + 128) >> 8 };
+				return (normalTexel & 0x0000ffff) | luminance << 16 | 0xff000000;
+			});
+	}
+
+	//Puts the lower 16 bits of value in the even bits of the result
+	static uint32_t SpreadBits(uint32_t value)
+	{
+		value &= 0x0000ffff;
+		value = (value | (value << 8)) & 0x00ff00ff;
+		value = (value | (value << 4)) & 0x0f0f0f0f;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	void Texture::SetLayout(TextureLayout layout)
+	{
+		if (m_Format != TextureFormat::rgba8)
+			return;
+
+		//back to rows first with the old layout, so every layout can be converted to every other one
+		std::vector<std::vector<uint32_t>> rows(m_MipLevels.size());
+		for (size_t levelIndex{}; levelIndex < m_MipLevels.size(); ++levelIndex)
+		{
+			const MipLevel& level{ m_MipLevels[levelIndex] };
+			rows[levelIndex].resize(static_cast<size_t>(level.width) * level.height);
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					rows[levelIndex][y * level.width + x] = level.texels[GetTexelIndex(level, x, y)];
+				}
+			}
+		}
+
+		m_Layout = layout;
+
+		for (size_t levelIndex{}; levelIndex < m_MipLevels.size(); ++levelIndex)
+		{
+			MipLevel& level{ m_MipLevels[levelIndex] };
 
-		Uint8 rValue{}, gValue{}, bValue{}, alphaValue{};
-		SDL_GetRGBA(pixel, m_pSurface->format, &rValue, &gValue, &bValue, &alphaValue);
+			switch (layout)
+			{
+			case TextureLayout::linear:
+				level.blockShift = 0;
+				break;
 
-		return { rValue / 255.f, gValue / 255.f, bValue / 255.f, alphaValue / 255.f };
+			case TextureLayout::tiled4x4:
+				level.blockShift = 2;
+				break;
+
+			case TextureLayout::tiled8x8:
+				level.blockShift = 3;
+				break;
+
+			case TextureLayout::morton:
+				//the largest power of two square that fits in the level, so a rectangle doesn't waste half its memory
+				level.blockShift = 0;
+				while ((2 << level.blockShift) <= std::min(level.width, level.height))
+				{
+					++level.blockShift;
+				}
+				break;
+			}
+
+			//partial blocks at the right and bottom edge are padded
+			const int blockSize{ 1 << level.blockShift };
+			level.blocksPerRow = (level.width + blockSize - 1) >> level.blockShift;
+			const int blocksPerColumn{ (level.height + blockSize - 1) >> level.blockShift };
+			level.texels.assign(static_cast<size_t>(level.blocksPerRow) * blocksPerColumn << (2 * level.blockShift), 0);
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					level.texels[GetTexelIndex(level, x, y)] = rows[levelIndex][y * level.width + x];
+				}
+			}
+		}
+	}
+
+	TextureLayout Texture::GetLayout() const
+	{
+		return m_Layout;
+	}
+
+	TextureFormat Texture::GetFormat() const
+	{
+		return m_Format;
+	}
+
+	size_t Texture::GetTexelIndex(const MipLevel& level, int x, int y) const
+	{
+		if (m_Layout == TextureLayout::linear)
+			return static_cast<size_t>(y) * level.width + x;
+
+		const int mask{ (1 << level.blockShift) - 1 };
+		const size_t blockIndex{ static_cast<size_t>(y >> level.blockShift) * level.blocksPerRow + (x >> level.blockShift) };
+
+		size_t indexInBlock{};
+		if (m_Layout == TextureLayout::morton)
+		{
+			indexInBlock = SpreadBits(x & mask) | SpreadBits(y & mask) << 1;
+		}
+		else
+		{
+			indexInBlock = (y & mask) << level.blockShift | (x & mask);
+		}
+
+		return (blockIndex << (2 * level.blockShift)) + indexInBlock;
+	}
+
+	void Texture::GenerateMipLevels()
+	{
+		//every texel of the next level is the rounded average of the 2x2 texels it covers, odd sizes repeat the last row or column
+		while (m_MipLevels.back().width > 1 || m_MipLevels.back().height > 1)
+		{
+			const MipLevel& previous{ m_MipLevels.back() };
+			MipLevel level{ std::max(previous.width / 2, 1), std::max(previous.height / 2, 1) };
+			level.texels.resize(static_cast<size_t>(level.width) * level.height);
+
+			for (int y{}; y < level.height; ++y)
+			{
+				const int previousY0{ std::min(2 * y, previous.height - 1) };
+				const int previousY1{ std::min(2 * y + 1, previous.height - 1) };
+
+				for (int x{}; x < level.width; ++x)
+				{
+					const int previousX0{ std::min(2 * x, previous.width - 1) };
+					const int previousX1{ std::min(2 * x + 1, previous.width - 1) };
+
+					const uint32_t texels[4]
+					{
+						previous.texels[previousY0 * previous.width + previousX0],
+						previous.texels[previousY0 * previous.width + previousX1],
+						previous.texels[previousY1 * previous.width + previousX0],
+						previous.texels[previousY1 * previous.width + previousX1]
+					};
+
+					uint32_t average{};
+					for (int shift{}; shift < 32; shift += 8)
+					{
+						uint32_t sum{ 2 };
+						for (uint32_t texel : texels)
+						{
+							sum += (texel >> shift) & 0xff;
+						}
+						average |= (sum / 4) << shift;
+					}
+
+					level.texels[y * level.width + x] = average;
+				}
+			}
+
+			m_MipLevels.push_back(std::move(level));
+		}
+	}
+
+	//Unpacks a texel, scaling to [0, 1] is a multiply by a constant
+	static ColorRGBA UnpackTexel(uint32_t texel)
+	{
+		constexpr float normalize{ 1.f / 255.f };
+		return
+		{
+			(texel & 0xff) * normalize,
+			((texel >> 8) & 0xff) * normalize,
+			((texel >> 16) & 0xff) * normalize,
+			(texel >> 24) * normalize
+		};
+	}
+
+	uint32_t Texture::FetchTexel(const MipLevel& level, int x, int y) const
+	{
+		if (m_Format == TextureFormat::rgba8)
+			return level.texels[GetTexelIndex(level, x, y)];
+
+		//every thread keeps the block it decoded last, neighbouring samples mostly fall in the same block
+		thread_local DecodedBlock decodedBlock{};
+
+		const uint32_t* pBlock{ GetTexelAddress(level, x, y) };
+		if (decodedBlock.pBlock != pBlock || decodedBlock.textureId != m_Id)
+		{
+			DecodeBlock(m_Format, reinterpret_cast<const uint8_t*>(pBlock), decodedBlock.texels);
+			decodedBlock.textureId = m_Id;
+			decodedBlock.pBlock = pBlock;
+		}
+
+		return decodedBlock.texels[(y & 3) << 2 | (x & 3)];
+	}
+
+	const uint32_t* Texture::GetTexelAddress(const MipLevel& level, int x, int y) const
+	{
+		if (m_Format == TextureFormat::rgba8)
+			return level.texels.data() + GetTexelIndex(level, x, y);
+
+		//a block compressed texel is in its block
+		const size_t blockIndex{ static_cast<size_t>(y >> 2) * level.blocksPerRow + (x >> 2) };
+		return level.texels.data() + blockIndex * (GetBlockSize(m_Format) / sizeof(uint32_t));
+	}
+
+	ColorRGBA Texture::GetTexel(const MipLevel& level, int x, int y) const
+	{
+		//clamp to the edge
+		x = std::clamp(x, 0, level.width - 1);
+		y = std::clamp(y, 0, level.height - 1);
+
+		return UnpackTexel(FetchTexel(level, x, y));
+	}
+
+	Texture::BilinearFootprint Texture::GetBilinearFootprint(const MipLevel& level, const Vector2& uv) const
+	{
+		//texel centers are at half integers
+		const float x{ std::clamp(uv.x, 0.f, 1.f) * level.width - 0.5f };
+		const float y{ std::clamp(uv.y, 0.f, 1.f) * level.height - 0.5f };
+		const float floorX{ std::floor(x) };
+		const float floorY{ std::floor(y) };
+
+		//the uv is clamped, so only the first texel can be before the edge and only the second one past it
+		return
+		{
+			std::max(static_cast<int>(floorX), 0),
+			std::max(static_cast<int>(floorY), 0),
+			std::min(static_cast<int>(floorX) + 1, level.width - 1),
+			std::min(static_cast<int>(floorY) + 1, level.height - 1),
+			x - floorX,
+			y - floorY
+		};
+	}
+
+	ColorRGBA Texture::SampleBilinear(const MipLevel& level, const Vector2& uv) const
+	{
+		const BilinearFootprint footprint{ GetBilinearFootprint(level, uv) };
+		const float fractionX{ footprint.fractionX };
+		const float fractionY{ footprint.fractionY };
+
+		//the format is checked once for the 4 texels
+		uint32_t texels[4]{};
+		if (m_Format == TextureFormat::rgba8)
+		{
+			texels[0] = level.texels[GetTexelIndex(level, footprint.x0, footprint.y0)];
+			texels[1] = level.texels[GetTexelIndex(level, footprint.x1, footprint.y0)];
+			texels[2] = level.texels[GetTexelIndex(level, footprint.x0, footprint.y1)];
+			texels[3] = level.texels[GetTexelIndex(level, footprint.x1, footprint.y1)];
+		}
+		else
+		{
+			texels[0] = FetchTexel(level, footprint.x0, footprint.y0);
+			texels[1] = FetchTexel(level, footprint.x1, footprint.y0);
+			texels[2] = FetchTexel(level, footprint.x0, footprint.y1);
+			texels[3] = FetchTexel(level, footprint.x1, footprint.y1);
+		}
+
+		const ColorRGBA top{ UnpackTexel(texels[0]) * (1.f - fractionX) + UnpackTexel(texels[1]) * fractionX };
+		const ColorRGBA bottom{ UnpackTexel(texels[2]) * (1.f - fractionX) + UnpackTexel(texels[3]) * fractionX };
+
+		return top * (1.f - fractionY) + bottom * fractionY;
+	}
+
+	void Texture::SelectLevels(const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode, int& level, float& fraction) const
+	{
+		//the level where one step on the screen is one texel, based on the direction in which the uv changes the most
+		const float width{ static_cast<float>(m_MipLevels.front().width) };
+		const float height{ static_cast<float>(m_MipLevels.front().height) };
+		const float ddxLengthSquared{ Square(uvDdx.x * width) + Square(uvDdx.y * height) };
+		const float ddyLengthSquared{ Square(uvDdy.x * width) + Square(uvDdy.y * height) };
+
+		const float maxLevel{ static_cast<float>(m_MipLevels.size() - 1) };
+		float levelOfDetail{ std::clamp(0.5f * std::log2(std::max(ddxLengthSquared, ddyLengthSquared)), 0.f, maxLevel) };
+
+		//NaN derivatives pass the clamp, they read the full resolution instead of converting NaN to a level
+		if (!(levelOfDetail >= 0.f))
+		{
+			levelOfDetail = 0.f;
+		}
+
+		if (filterMode == FilterMode::bilinear)
+		{
+			level = static_cast<int>(levelOfDetail + 0.5f);
+			fraction = 0.f;
+			return;
+		}
+
+		level = static_cast<int>(levelOfDetail);
+		fraction = levelOfDetail - level;
+	}
+
+	ColorRGBA Texture::Sample(const Vector2& uv) const
+	{
+		PROFILE_COUNT(textureSamples, 1);
+
+		const MipLevel& level{ m_MipLevels.front() };
+		return GetTexel(level, static_cast<int>(std::clamp(uv.x, 0.f, 1.f) * level.width), static_cast<int>(std::clamp(uv.y, 0.f, 1.f) * level.height));
+	}
+
+	ColorRGBA Texture::Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode) const
+	{
+		if (filterMode == FilterMode::point)
+			return Sample(uv);
+
+		PROFILE_COUNT(textureSamples, 1);
+
+		int level{};
+		float fraction{};
+		SelectLevels(uvDdx, uvDdy, filterMode, level, fraction);
+
+		const ColorRGBA closerLevel{ SampleBilinear(m_MipLevels[level], uv) };
+		if (fraction == 0.f)
+			return closerLevel;
+
+		return closerLevel * (1.f - fraction) + SampleBilinear(m_MipLevels[level + 1], uv) * fraction;
+	}
+
+	void Texture::GetFootprint(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode, std::vector<const uint32_t*>& texels) const
+	{
+		if (filterMode == FilterMode::point)
+		{
+			const MipLevel& level{ m_MipLevels.front() };
+			const int x{ std::clamp(static_cast<int>(std::clamp(uv.x, 0.f, 1.f) * level.width), 0, level.width - 1) };
+			const int y{ std::clamp(static_cast<int>(std::clamp(uv.y, 0.f, 1.f) * level.height), 0, level.height - 1) };
+			texels.push_back(GetTexelAddress(level, x, y));
+			return;
+		}
+
+		int level{};
+		float fraction{};
+		SelectLevels(uvDdx, uvDdy, filterMode, level, fraction);
+
+		const int lastLevel{ fraction != 0.f ? level + 1 : level };
+		for (; level <= lastLevel; ++level)
+		{
+			const MipLevel& mipLevel{ m_MipLevels[level] };
+			const BilinearFootprint footprint{ GetBilinearFootprint(mipLevel, uv) };
+
+			texels.push_back(GetTexelAddress(mipLevel, footprint.x0, footprint.y0));
+			texels.push_back(GetTexelAddress(mipLevel, footprint.x1, footprint.y0));
+			texels.push_back(GetTexelAddress(mipLevel, footprint.x0, footprint.y1));
+			texels.push_back(GetTexelAddress(mipLevel, footprint.x1, footprint.y1));
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,7 +1,10 @@
 #pragma once
 #include <SDL_surface.h>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include "ColorRGB.h"
+#include "DataTypes.h"
 
 namespace dae
 {
@@ -10,15 +13,96 @@ namespace dae
 	class Texture
 	{
 	public:
-		~Texture();
+		~Texture() = default;
 
-		static Texture* LoadFromFile(const std::string& path);
-		ColorRGBA Sample(const Vector2& uv) ;
+		//.dds and .ktx files keep their block compression (bc1, bc3 and bc5) and their mip levels, other files are decoded to rgba8
+		//returns nullptr when a .dds or .ktx file can't be read or has a format that is not supported
+		static Texture* LoadFromFile(const std::string& path, TextureLayout layout = TextureLayout::linear);
+
+		//Material packing: two maps of the same size become one texture, so a shader fetches them at once.
+		//The packed texture is always rgba8 with a full mip chain, block compressed maps are decoded into it
+		//diffuse rgb in rgb and the glossiness in alpha
+		static Texture* PackDiffuseGlossiness(const Texture& diffuse, const Texture& glossiness);
+		//the x and y of the normal in red and green, the specular intensity in blue, the z of the normal is left to the shader
+		static Texture* PackNormalSpecular(const Texture& normal, const Texture& specular);
+
+		ColorRGBA Sample(const Vector2& uv) const;
+
+		//uvDdx and uvDdy are how much the uv changes to the next pixel on the screen, they select the mip level
+		ColorRGBA Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode) const;
+
+		//Reorders the texels of every mip level, block compressed textures are already stored in 4x4 blocks and keep their layout
+		void SetLayout(TextureLayout layout);
+		TextureLayout GetLayout() const;
+
+		TextureFormat GetFormat() const;
+
+		//The addresses of the texels Sample reads with these arguments, used to model the cache behaviour of a layout
+		void GetFootprint(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode, std::vector<const uint32_t*>& texels) const;
 		
 	private:
+		//The surface is only read once, the texture keeps its own decoded copy
 		Texture(SDL_Surface* pSurface);
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		//One level of the mip chain
+		//rgba8: every texel is packed as r | g << 8 | b << 16 | a << 24 no matter the format of the file
+		//block compressed: the 4x4 blocks as they are in the file, 2 (bc1) or 4 (bc3, bc5) elements per block
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			std::vector<uint32_t> texels{};
+
+			//blocked layouts and block compression: the blocks are blockShift texels wide and high and stored row after row
+			int blockShift{};
+			int blocksPerRow{};
+		};
+
+		//The last block a thread decoded, bilinear samples mostly read the same block again
+		struct DecodedBlock
+		{
+			uint64_t textureId{}; //0 when nothing was decoded yet
+			const uint32_t* pBlock{};
+			uint32_t texels[16]{};
+		};
+
+		Texture(MipLevel&& fullResolution);
+
+		//Block compressed texture with the mip levels of the file, the chain is not extended
+		Texture(TextureFormat format, std::vector<MipLevel>&& mipLevels);
+
+		static Texture* LoadDDS(const std::vector<uint8_t>& file);
+		static Texture* LoadKTX(const std::vector<uint8_t>& file);
+		static Texture* CreateBlockCompressed(TextureFormat format, int width, int height, const std::vector<const uint8_t*>& levelData);
+
+		//Builds a texture out of the full resolution texels of two textures of the same size, combine gets them packed and returns the packed result
+		static Texture* Pack(const Texture& first, const Texture& second, uint32_t(*combine)(uint32_t first, uint32_t second));
+
+		//The 4 texels a bilinear sample reads (top left, top right, bottom left, bottom right) and how much the right and bottom ones weigh
+		struct BilinearFootprint
+		{
+			int x0{};
+			int y0{};
+			int x1{};
+			int y1{};
+			float fractionX{};
+			float fractionY{};
+		};
+
+		void GenerateMipLevels();
+		size_t GetTexelIndex(const MipLevel& level, int x, int y) const;
+		uint32_t FetchTexel(const MipLevel& level, int x, int y) const;
+		const uint32_t* GetTexelAddress(const MipLevel& level, int x, int y) const;
+		ColorRGBA GetTexel(const MipLevel& level, int x, int y) const;
+		BilinearFootprint GetBilinearFootprint(const MipLevel& level, const Vector2& uv) const;
+		ColorRGBA SampleBilinear(const MipLevel& level, const Vector2& uv) const;
+
+		//the first mip level Sample reads and the weight of the next one, which is 0 when only one level is read
+		void SelectLevels(const Vector2& uvDdx, const Vector2& uvDdy, FilterMode filterMode, int& level, float& fraction) const;
+
+		std::vector<MipLevel> m_MipLevels{}; //level 0 is the full resolution, every next level is half the size down to 1x1
+		TextureLayout m_Layout{ TextureLayout::linear };
+		TextureFormat m_Format{ TextureFormat::rgba8 };
+		uint64_t m_Id{}; //unique for every texture, so a decoded block is never mistaken for one of a texture that was freed
 	};
-}
\ No newline at end of file
+}
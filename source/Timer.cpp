@@ -58,6 +58,11 @@ void Timer::Update()
 		m_ElapsedTime = m_ElapsedUpperBound;
 	}
 
+	if (m_FixedTimeStep > 0.0f)
+	{
+		m_ElapsedTime = m_FixedTimeStep;
+	}
+
 	m_TotalTime = (float)(((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount);
 
 	//FPS LOGIC
@@ -21,6 +21,9 @@ namespace dae
 		void Update();
 		void Stop();
 
+		//Every Update reports this many seconds as elapsed instead of the measured time, 0 measures again
+		void SetFixedTimeStep(float seconds) { m_FixedTimeStep = seconds; };
+
 		uint32_t GetFPS() const { return m_FPS; };
 		float GetdFPS() const { return m_dFPS; };
 		float GetElapsed() const { return m_ElapsedTime; };
@@ -43,6 +46,7 @@ namespace dae
 		float m_SecondsPerCount = 0.0f;
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
+		float m_FixedTimeStep = 0.0f;
 
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
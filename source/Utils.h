@@ -1,8 +1,18 @@
 #pragma once
 #include <cassert>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <thread>
+#include <type_traits>
 #include "Math.h"
 #include "DataTypes.h"
+#include "MemoryMappedFile.h"
 
 //#define DISABLE_OBJ
 
@@ -10,9 +20,258 @@ namespace dae
 {
 	namespace Utils
 	{
-		//Just parses vertices and indices
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
+		//OBJ scanning, every function reads from pCurrent up to the end of the line and moves pCurrent past what it read
+		constexpr uint32_t g_NoObjIndex{ UINT32_MAX };
+
+		static const char* SkipObjSpaces(const char* pCurrent, const char* pLineEnd)
+		{
+			while (pCurrent < pLineEnd && (*pCurrent == ' ' || *pCurrent == '\t' || *pCurrent == '\r'))
+			{
+				++pCurrent;
+			}
+			return pCurrent;
+		}
+
+		//true when the line starts with the command followed by a space
+		static bool IsObjCommand(const char* pCurrent, const char* pLineEnd, const char* pCommand)
+		{
+			while (*pCommand != '\0')
+			{
+				if (pCurrent == pLineEnd || *pCurrent++ != *pCommand++)
+					return false;
+			}
+			return pCurrent < pLineEnd && (*pCurrent == ' ' || *pCurrent == '\t');
+		}
+
+		static bool ParseObjFloat(const char*& pCurrent, const char* pLineEnd, float& value)
+		{
+			pCurrent = SkipObjSpaces(pCurrent, pLineEnd);
+
+			//from_chars doesn't take a plus sign
+			if (pCurrent < pLineEnd && *pCurrent == '+')
+			{
+				++pCurrent;
+			}
+
+			const std::from_chars_result result{ std::from_chars(pCurrent, pLineEnd, value) };
+			if (result.ec == std::errc::invalid_argument)
+				return false;
+
+			//out of the range of a float: a value that is too small for one becomes 0, a value that is too big makes the line malformed.
+			//A double tells which one it is, beyond the range of a double the sign of the exponent does
+			if (result.ec == std::errc::result_out_of_range)
+			{
+				bool isTooSmall{};
+				double wideValue{};
+				if (std::from_chars(pCurrent, pLineEnd, wideValue).ec == std::errc{})
+				{
+					isTooSmall = std::abs(wideValue) < 1.0;
+				}
+				else
+				{
+					const char* pExponent{ std::find_if(pCurrent, result.ptr, [](char character) { return character == 'e' || character == 'E'; }) };
+					isTooSmall = pExponent + 1 < result.ptr && pExponent[1] == '-';
+				}
+
+				if (!isTooSmall)
+					return false;
+
+				value = 0.f;
+			}
+
+			pCurrent = result.ptr;
+			return true;
+		}
+
+		//Turns a 1 based index into a 0 based one, a negative index counts back from the last element read so far
+		static bool ParseObjIndex(const char*& pCurrent, const char* pLineEnd, size_t amountRead, uint32_t& index)
+		{
+			int64_t value{};
+			const std::from_chars_result result{ std::from_chars(pCurrent, pLineEnd, value) };
+			if (result.ec != std::errc{} || value == 0)
+				return false;
+
+			const int64_t zeroBasedIndex{ value > 0 ? value - 1 : static_cast<int64_t>(amountRead) + value };
+			if (zeroBasedIndex < 0 || zeroBasedIndex >= g_NoObjIndex)
+				return false;
+
+			pCurrent = result.ptr;
+			index = static_cast<uint32_t>(zeroBasedIndex);
+			return true;
+		}
+
+		//A vertex of a face, the uv and normal are g_NoObjIndex when the face leaves them out
+		struct ObjCorner
+		{
+			uint32_t position{};
+			uint32_t uv{ g_NoObjIndex };
+			uint32_t normal{ g_NoObjIndex };
+
+			bool operator==(const ObjCorner& other) const
+			{
+				return position == other.position && uv == other.uv && normal == other.normal;
+			}
+		};
+
+		static size_t HashObjCorner(const ObjCorner& corner)
+		{
+			uint64_t hash{ corner.position * 0x9E3779B97F4A7C15ull };
+			hash = (hash ^ (hash >> 31) ^ corner.uv) * 0xBF58476D1CE4E5B9ull;
+			hash = (hash ^ (hash >> 27) ^ corner.normal) * 0x94D049BB133111EBull;
+			return static_cast<size_t>(hash ^ (hash >> 31));
+		}
+
+		//A range of whole lines that is parsed on its own thread.
+		//The attributes are counted first, so every chunk knows where its attributes go and what a negative index refers to
+		struct ObjChunk
+		{
+			const char* pBegin{};
+			const char* pEnd{};
+
+			size_t amountOfPositions{};
+			size_t amountOfUVs{};
+			size_t amountOfNormals{};
+			size_t amountOfFaces{};
+			size_t firstPosition{};
+			size_t firstUV{};
+			size_t firstNormal{};
+
+			std::vector<ObjCorner> corners{}; //of every face
+			std::vector<uint32_t> indices{}; //triangles indexing corners
+			std::vector<uint32_t> cornerVertices{}; //the welded vertex of every corner
+			size_t firstVertex{}; //the vertices this chunk used first follow each other from here
+
+			bool isValid{ true };
+		};
+
+		template<typename Function>
+		static void ForEachObjLine(const char* pBegin, const char* pEnd, Function function)
+		{
+			while (pBegin < pEnd)
+			{
+				const char* pLineEnd{ static_cast<const char*>(std::memchr(pBegin, '\n', pEnd - pBegin)) };
+				if (!pLineEnd)
+				{
+					pLineEnd = pEnd;
+				}
+
+				if (!function(SkipObjSpaces(pBegin, pLineEnd), pLineEnd))
+					return;
+
+				pBegin = pLineEnd + 1;
+			}
+		}
+
+		static void CountObjAttributes(ObjChunk& chunk)
+		{
+			ForEachObjLine(chunk.pBegin, chunk.pEnd, [&](const char* pCurrent, const char* pLineEnd)
+				{
+					if (IsObjCommand(pCurrent, pLineEnd, "v"))
+						++chunk.amountOfPositions;
+					else if (IsObjCommand(pCurrent, pLineEnd, "vt"))
+						++chunk.amountOfUVs;
+					else if (IsObjCommand(pCurrent, pLineEnd, "vn"))
+						++chunk.amountOfNormals;
+					else if (IsObjCommand(pCurrent, pLineEnd, "f"))
+						++chunk.amountOfFaces;
+					return true;
+				});
+		}
+
+		//Writes the attributes of the chunk at its offsets and triangulates its faces as a fan, polygons have to be convex
+		static void ParseObjChunk(ObjChunk& chunk, std::vector<Vector3>& positions, std::vector<Vector2>& UVs, std::vector<Vector3>& normals, bool flipAxisAndWinding)
+		{
+			size_t positionIndex{ chunk.firstPosition };
+			size_t uvIndex{ chunk.firstUV };
+			size_t normalIndex{ chunk.firstNormal };
+
+			//most files only have triangles
+			chunk.corners.reserve(3 * chunk.amountOfFaces);
+			chunk.indices.reserve(3 * chunk.amountOfFaces);
+
+			ForEachObjLine(chunk.pBegin, chunk.pEnd, [&](const char* pCurrent, const char* pLineEnd)
+				{
+					if (IsObjCommand(pCurrent, pLineEnd, "v"))
+					{
+						Vector3& position{ positions[positionIndex++] };
+						pCurrent += 1;
+						chunk.isValid = ParseObjFloat(pCurrent, pLineEnd, position.x) && ParseObjFloat(pCurrent, pLineEnd, position.y) && ParseObjFloat(pCurrent, pLineEnd, position.z);
+					}
+					else if (IsObjCommand(pCurrent, pLineEnd, "vt"))
+					{
+						//the v is optional and the texture is stored upside down
+						float u{};
+						float v{};
+						pCurrent += 2;
+						chunk.isValid = ParseObjFloat(pCurrent, pLineEnd, u);
+						if (SkipObjSpaces(pCurrent, pLineEnd) < pLineEnd)
+						{
+							chunk.isValid = chunk.isValid && ParseObjFloat(pCurrent, pLineEnd, v);
+						}
+						UVs[uvIndex++] = { u, 1 - v };
+					}
+					else if (IsObjCommand(pCurrent, pLineEnd, "vn"))
+					{
+						Vector3& normal{ normals[normalIndex++] };
+						pCurrent += 2;
+						chunk.isValid = ParseObjFloat(pCurrent, pLineEnd, normal.x) && ParseObjFloat(pCurrent, pLineEnd, normal.y) && ParseObjFloat(pCurrent, pLineEnd, normal.z);
+					}
+					else if (IsObjCommand(pCurrent, pLineEnd, "f"))
+					{
+						//every corner is position[/[uv][/normal]]
+						const uint32_t firstCorner{ static_cast<uint32_t>(chunk.corners.size()) };
+						pCurrent = SkipObjSpaces(pCurrent + 1, pLineEnd);
+						while (chunk.isValid && pCurrent < pLineEnd)
+						{
+							ObjCorner corner{};
+							chunk.isValid = ParseObjIndex(pCurrent, pLineEnd, positionIndex, corner.position);
+
+							if (chunk.isValid && pCurrent < pLineEnd && *pCurrent == '/')
+							{
+								++pCurrent;
+								if (pCurrent < pLineEnd && *pCurrent != '/')
+								{
+									chunk.isValid = ParseObjIndex(pCurrent, pLineEnd, uvIndex, corner.uv);
+								}
+
+								if (chunk.isValid && pCurrent < pLineEnd && *pCurrent == '/')
+								{
+									++pCurrent;
+									chunk.isValid = ParseObjIndex(pCurrent, pLineEnd, normalIndex, corner.normal);
+								}
+							}
+
+							chunk.corners.push_back(corner);
+							pCurrent = SkipObjSpaces(pCurrent, pLineEnd);
+						}
+
+						const uint32_t amountOfCorners{ static_cast<uint32_t>(chunk.corners.size()) - firstCorner };
+						chunk.isValid = chunk.isValid && amountOfCorners >= 3;
+
+						for (uint32_t corner{ 1 }; chunk.isValid && corner + 1 < amountOfCorners; ++corner)
+						{
+							chunk.indices.push_back(firstCorner);
+							if (flipAxisAndWinding)
+							{
+								chunk.indices.push_back(firstCorner + corner + 1);
+								chunk.indices.push_back(firstCorner + corner);
+							}
+							else
+							{
+								chunk.indices.push_back(firstCorner + corner);
+								chunk.indices.push_back(firstCorner + corner + 1);
+							}
+						}
+					}
+
+					return chunk.isValid;
+				});
+		}
+
+		//Parses positions, uvs and normals, the polygons are triangulated and corners that share all their attributes share a vertex.
+		//The file is memory mapped and split in chunks of lines that are parsed in parallel, returns false when it can't be read or is malformed
 		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
 		{
 #ifdef DISABLE_OBJ
@@ -23,109 +282,159 @@ namespace dae
 
 #else
 
-			std::ifstream file(filename);
-			if (!file)
+			const MemoryMappedFile file{ filename };
+			if (!file.IsOpen())
 				return false;
 
-			std::vector<Vector3> positions{};
-			std::vector<Vector3> normals{};
-			std::vector<Vector2> UVs{};
-
 			vertices.clear();
 			indices.clear();
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			//chunks of at least 1 MB, a few per thread so a chunk with more faces doesn't keep the others waiting
+			constexpr size_t minimumChunkSize{ size_t{ 1 } << 20 };
+			const size_t maximumAmountOfChunks{ 4 * std::max(std::thread::hardware_concurrency(), 1u) };
+			const size_t amountOfChunks{ std::clamp(file.GetSize() / minimumChunkSize, size_t{ 1 }, maximumAmountOfChunks) };
+
+			std::vector<ObjChunk> chunks{};
+			const char* pFileEnd{ file.GetData() + file.GetSize() };
+			const char* pChunkBegin{ file.GetData() };
+			for (size_t chunkIndex{ 1 }; chunkIndex <= amountOfChunks && pChunkBegin < pFileEnd; ++chunkIndex)
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
+				//every chunk but the last ends after the line its share of the file ends in
+				const char* pChunkEnd{ pFileEnd };
+				if (chunkIndex < amountOfChunks)
 				{
-					// Ignore Comment
+					pChunkEnd = std::max(pChunkBegin, file.GetData() + file.GetSize() * chunkIndex / amountOfChunks);
+					const char* pLineEnd{ static_cast<const char*>(std::memchr(pChunkEnd, '\n', pFileEnd - pChunkEnd)) };
+					pChunkEnd = pLineEnd ? pLineEnd + 1 : pFileEnd;
 				}
-				else if (sCommand == "v")
-				{
-					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
 
-					positions.emplace_back(x, y, z);
-				}
-				else if (sCommand == "vt")
-				{
-					// Vertex TexCoord
-					float u, v;
-					file >> u >> v;
-					UVs.emplace_back(u, 1 - v);
-				}
-				else if (sCommand == "vn")
+				ObjChunk chunk{};
+				chunk.pBegin = pChunkBegin;
+				chunk.pEnd = pChunkEnd;
+				chunks.emplace_back(std::move(chunk));
+				pChunkBegin = pChunkEnd;
+			}
+
+			std::for_each(std::execution::par, chunks.begin(), chunks.end(), CountObjAttributes);
+
+			size_t amountOfPositions{};
+			size_t amountOfUVs{};
+			size_t amountOfNormals{};
+			for (ObjChunk& chunk : chunks)
+			{
+				chunk.firstPosition = amountOfPositions;
+				chunk.firstUV = amountOfUVs;
+				chunk.firstNormal = amountOfNormals;
+				amountOfPositions += chunk.amountOfPositions;
+				amountOfUVs += chunk.amountOfUVs;
+				amountOfNormals += chunk.amountOfNormals;
+			}
+
+			std::vector<Vector3> positions(amountOfPositions);
+			std::vector<Vector2> UVs(amountOfUVs);
+			std::vector<Vector3> normals(amountOfNormals);
+
+			std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](ObjChunk& chunk)
 				{
-					// Vertex Normal
-					float x, y, z;
-					file >> x >> y >> z;
+					ParseObjChunk(chunk, positions, UVs, normals, flipAxisAndWinding);
+				});
 
-					normals.emplace_back(x, y, z);
-				}
-				else if (sCommand == "f")
+			size_t amountOfCorners{};
+			size_t amountOfIndices{};
+			for (const ObjChunk& chunk : chunks)
+			{
+				if (!chunk.isValid)
+					return false;
+
+				amountOfCorners += chunk.corners.size();
+				amountOfIndices += chunk.indices.size();
+			}
+
+			if (amountOfCorners >= g_NoObjIndex)
+				return false;
+
+			//welding: corners with the same position, uv and normal become one vertex, in the order they are first used.
+			//Open addressing with linear probing, the table is at most half full
+			const size_t tableSize{ std::bit_ceil(2 * amountOfCorners + 1) };
+			std::vector<uint32_t> vertexTable(tableSize, g_NoObjIndex);
+			std::vector<ObjCorner> uniqueCorners{};
+			uniqueCorners.reserve(amountOfCorners);
+
+			for (ObjChunk& chunk : chunks)
+			{
+				chunk.firstVertex = uniqueCorners.size();
+				chunk.cornerVertices.resize(chunk.corners.size());
+
+				for (size_t cornerIndex{}; cornerIndex < chunk.corners.size(); ++cornerIndex)
 				{
-					//if a face is read:
-					//construct the 3 vertices, add them to the vertex array
-					//add three indices to the index array
-					//add the material index as attibute to the attribute array
-					//
-					// Faces or triangles
-					Vertex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
-
-					uint32_t tempIndices[3];
-					for (size_t iFace = 0; iFace < 3; iFace++)
+					const ObjCorner& corner{ chunk.corners[cornerIndex] };
+					size_t slot{ HashObjCorner(corner) & (tableSize - 1) };
+					while (vertexTable[slot] != g_NoObjIndex && !(uniqueCorners[vertexTable[slot]] == corner))
 					{
-						// OBJ format uses 1-based arrays
-						file >> iPosition;
-						vertex.position = positions[iPosition - 1];
+						slot = (slot + 1) & (tableSize - 1);
+					}
 
-						if ('/' == file.peek())//is next in buffer ==  '/' ?
-						{
-							file.ignore();//read and ignore one element ('/')
+					if (vertexTable[slot] == g_NoObjIndex)
+					{
+						vertexTable[slot] = static_cast<uint32_t>(uniqueCorners.size());
+						uniqueCorners.push_back(corner);
+					}
 
-							if ('/' != file.peek())
-							{
-								// Optional texture coordinate
-								file >> iTexCoord;
-								vertex.uv = UVs[iTexCoord - 1];
-							}
+					chunk.cornerVertices[cornerIndex] = vertexTable[slot];
+				}
+			}
 
-							if ('/' == file.peek())
-							{
-								file.ignore();
+			//every chunk fills in the vertices it used first and its own indices
+			vertices.resize(uniqueCorners.size());
+			indices.resize(amountOfIndices);
 
-								// Optional vertex normal
-								file >> iNormal;
-								vertex.normal = normals[iNormal - 1];
-							}
-						}
+			std::vector<size_t> firstIndices(chunks.size());
+			for (size_t chunkIndex{ 1 }; chunkIndex < chunks.size(); ++chunkIndex)
+			{
+				firstIndices[chunkIndex] = firstIndices[chunkIndex - 1] + chunks[chunkIndex - 1].indices.size();
+			}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
-					}
+			std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](ObjChunk& chunk)
+				{
+					const size_t chunkIndex{ static_cast<size_t>(&chunk - chunks.data()) };
+					const size_t lastVertex{ chunkIndex + 1 < chunks.size() ? chunks[chunkIndex + 1].firstVertex : uniqueCorners.size() };
 
-					indices.push_back(tempIndices[0]);
-					if (flipAxisAndWinding) 
+					//a positive index can point past the attributes of its own chunk, so the indices are only checked once all of them are known
+					for (size_t vertexIndex{ chunk.firstVertex }; vertexIndex < lastVertex; ++vertexIndex)
 					{
-						indices.push_back(tempIndices[2]);
-						indices.push_back(tempIndices[1]);
+						const ObjCorner& corner{ uniqueCorners[vertexIndex] };
+						if (corner.position >= amountOfPositions
+							|| (corner.uv != g_NoObjIndex && corner.uv >= amountOfUVs)
+							|| (corner.normal != g_NoObjIndex && corner.normal >= amountOfNormals))
+						{
+							chunk.isValid = false;
+							return;
+						}
+
+						Vertex& vertex{ vertices[vertexIndex] };
+						vertex.position = positions[corner.position];
+						if (corner.uv != g_NoObjIndex)
+						{
+							vertex.uv = UVs[corner.uv];
+						}
+						if (corner.normal != g_NoObjIndex)
+						{
+							vertex.normal = normals[corner.normal];
+						}
 					}
-					else
+
+					const size_t firstIndex{ firstIndices[chunkIndex] };
+					for (size_t index{}; index < chunk.indices.size(); ++index)
 					{
-						indices.push_back(tempIndices[1]);
-						indices.push_back(tempIndices[2]);
+						indices[firstIndex + index] = chunk.cornerVertices[chunk.indices[index]];
 					}
-				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
+				});
+
+			if (std::any_of(chunks.begin(), chunks.end(), [](const ObjChunk& chunk) { return !chunk.isValid; }))
+			{
+				vertices.clear();
+				indices.clear();
+				return false;
 			}
 
 			//Cheap Tangent Calculations
@@ -148,6 +457,10 @@ namespace dae
 				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
 				float r = 1.f / Vector2::Cross(diffX, diffY);
 
+				//a triangle without uv area has no tangent, it would turn the tangents of the vertices it shares into NaN
+				if (!std::isfinite(r))
+					continue;
+
 				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
 				vertices[index0].tangent += tangent;
 				vertices[index1].tangent += tangent;
@@ -171,6 +484,199 @@ namespace dae
 			return true;
 #endif
 		}
+
+		//The binary cache LoadMesh keeps next to an OBJ: this header followed by the vertices and the indices exactly as Mesh holds them.
+		//It is only ever read on the machine that wrote it, so it is in the native byte order
+		constexpr uint32_t g_MeshCacheVersion{ 2 }; //increase when ParseOBJ produces different vertices or the header changes, so old caches are parsed again
+		constexpr uint64_t g_MeshCacheAlignment{ 64 }; //every section starts on a cache line, the mapping itself is page aligned
+
+		struct MeshCacheHeader
+		{
+			char magic[4]{ 'D', 'A', 'E', 'M' };
+			uint32_t version{ g_MeshCacheVersion };
+			uint32_t vertexSize{ sizeof(Vertex) };
+			uint32_t isFlipped{};
+
+			//of the OBJ the cache was made from, a cache of an older OBJ is ignored
+			uint64_t sourceSize{};
+			int64_t sourceWriteTime{};
+
+			uint64_t amountOfVertices{};
+			uint64_t amountOfIndices{};
+			uint64_t verticesOffset{};
+			uint64_t indicesOffset{};
+		};
+
+		static_assert(std::is_trivially_copyable_v<Vertex> && std::is_trivially_copyable_v<MeshCacheHeader>, "The mesh cache is copied byte for byte");
+
+		static uint64_t AlignMeshCacheOffset(uint64_t offset)
+		{
+			return (offset + g_MeshCacheAlignment - 1) & ~(g_MeshCacheAlignment - 1);
+		}
+
+		//Returns false when the cache is missing, made from another version of the source or doesn't hold all its sections
+		static bool ReadMeshCache(const std::string& cacheFilename, const MeshCacheHeader& expectedHeader, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const MemoryMappedFile file{ cacheFilename };
+			if (!file.IsOpen() || file.GetSize() < sizeof(MeshCacheHeader))
+				return false;
+
+			MeshCacheHeader header{};
+			std::memcpy(&header, file.GetData(), sizeof(MeshCacheHeader));
+
+			if (std::memcmp(header.magic, expectedHeader.magic, sizeof(header.magic)) != 0
+				|| header.version != expectedHeader.version
+				|| header.vertexSize != expectedHeader.vertexSize
+				|| header.isFlipped != expectedHeader.isFlipped
+				|| header.sourceSize != expectedHeader.sourceSize
+				|| header.sourceWriteTime != expectedHeader.sourceWriteTime)
+				return false;
+
+			//the counts are checked against the file size first, so the section sizes can't overflow
+			const uint64_t fileSize{ file.GetSize() };
+			if (header.amountOfVertices > fileSize / sizeof(Vertex) || header.amountOfIndices > fileSize / sizeof(uint32_t)
+				|| header.verticesOffset > fileSize - header.amountOfVertices * sizeof(Vertex)
+				|| header.indicesOffset > fileSize - header.amountOfIndices * sizeof(uint32_t)
+				|| header.amountOfVertices >= g_NoObjIndex)
+				return false;
+
+			//the mapped sections are in the layout of the vectors, so they are filled with one copy each
+			vertices.resize(header.amountOfVertices);
+			indices.resize(header.amountOfIndices);
+			std::memcpy(vertices.data(), file.GetData() + header.verticesOffset, vertices.size() * sizeof(Vertex));
+			std::memcpy(indices.data(), file.GetData() + header.indicesOffset, indices.size() * sizeof(uint32_t));
+
+			if (std::any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= vertices.size(); }))
+			{
+				vertices.clear();
+				indices.clear();
+				return false;
+			}
+
+			return true;
+		}
+
+		//Returns false when the cache could not be written, a partly written cache fails the checks of ReadMeshCache
+		static bool WriteMeshCache(const std::string& cacheFilename, MeshCacheHeader header, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			std::ofstream file{ cacheFilename, std::ios::binary | std::ios::trunc };
+			if (!file)
+				return false;
+
+			header.amountOfVertices = vertices.size();
+			header.amountOfIndices = indices.size();
+			header.verticesOffset = AlignMeshCacheOffset(sizeof(MeshCacheHeader));
+			header.indicesOffset = AlignMeshCacheOffset(header.verticesOffset + vertices.size() * sizeof(Vertex));
+
+			constexpr char padding[g_MeshCacheAlignment]{};
+			file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+			file.write(padding, header.verticesOffset - sizeof(MeshCacheHeader));
+			file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+			file.write(padding, header.indicesOffset - header.verticesOffset - vertices.size() * sizeof(Vertex));
+			file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+
+			return static_cast<bool>(file);
+		}
+
+		//ParseOBJ through a binary cache: the first load writes <filename>.mesh next to the OBJ, later loads map that file instead of
+		//parsing, welding and computing the tangents again. The cache is made again when the OBJ changes
+		static bool LoadMesh(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		{
+			//without the size and the time of the OBJ a cache can't be checked, it is only parsed
+			std::error_code error{};
+			const uint64_t sourceSize{ std::filesystem::file_size(filename, error) };
+			if (error)
+				return ParseOBJ(filename, vertices, indices, flipAxisAndWinding);
+
+			const auto sourceWriteTime{ std::filesystem::last_write_time(filename, error) };
+			if (error)
+				return ParseOBJ(filename, vertices, indices, flipAxisAndWinding);
+
+			MeshCacheHeader header{};
+			header.isFlipped = flipAxisAndWinding;
+			header.sourceSize = sourceSize;
+			header.sourceWriteTime = static_cast<int64_t>(sourceWriteTime.time_since_epoch().count());
+
+			const std::string cacheFilename{ filename + ".mesh" };
+			if (ReadMeshCache(cacheFilename, header, vertices, indices))
+				return true;
+
+			if (!ParseOBJ(filename, vertices, indices, flipAxisAndWinding))
+				return false;
+
+			//a folder that can't be written to only costs the parse on the next load
+			if (!WriteMeshCache(cacheFilename, header, vertices, indices))
+			{
+				std::filesystem::remove(cacheFilename, error);
+			}
+
+			return true;
+		}
+
+		//One keyframe per line: time x y z yaw pitch fov sceneRotation, lines starting with # are comments.
+		//The keyframes are sorted on their time, returns false when the file can't be read or a line is incomplete
+		static bool ParseCameraPath(const std::string& filename, std::vector<CameraKeyframe>& keyframes)
+		{
+			std::ifstream file(filename);
+			if (!file)
+				return false;
+
+			keyframes.clear();
+
+			std::string line;
+			while (std::getline(file, line))
+			{
+				std::istringstream lineStream{ line };
+				std::string firstWord;
+				if (!(lineStream >> firstWord) || firstWord[0] == '#')
+					continue;
+
+				lineStream.str(line);
+				lineStream.clear();
+
+				CameraKeyframe keyframe{};
+				if (!(lineStream >> keyframe.time >> keyframe.origin.x >> keyframe.origin.y >> keyframe.origin.z
+					>> keyframe.yaw >> keyframe.pitch >> keyframe.fovAngle >> keyframe.sceneRotation))
+					return false;
+
+				keyframes.push_back(keyframe);
+			}
+
+			std::stable_sort(keyframes.begin(), keyframes.end(), [](const CameraKeyframe& left, const CameraKeyframe& right)
+				{
+					return left.time < right.time;
+				});
+
+			return !keyframes.empty();
+		}
+
+		//Linearly interpolates the keyframes around the time, before the first and after the last keyframe the camera stands still
+		static CameraKeyframe SampleCameraPath(const std::vector<CameraKeyframe>& keyframes, float time)
+		{
+			assert(!keyframes.empty());
+
+			const auto next{ std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float time, const CameraKeyframe& keyframe)
+				{
+					return time < keyframe.time;
+				}) };
+
+			if (next == keyframes.begin())
+				return keyframes.front();
+			if (next == keyframes.end())
+				return keyframes.back();
+
+			const CameraKeyframe& previous{ *(next - 1) };
+			const float factor{ (time - previous.time) / (next->time - previous.time) };
+
+			CameraKeyframe keyframe{};
+			keyframe.time = time;
+			keyframe.origin = previous.origin + (next->origin - previous.origin) * factor;
+			keyframe.yaw = Lerpf(previous.yaw, next->yaw, factor);
+			keyframe.pitch = Lerpf(previous.pitch, next->pitch, factor);
+			keyframe.fovAngle = Lerpf(previous.fovAngle, next->fovAngle, factor);
+			keyframe.sceneRotation = Lerpf(previous.sceneRotation, next->sceneRotation, factor);
+			return keyframe;
+		}
 #pragma warning(pop)
 	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include "MathHelpers.h"
 
 namespace dae
 {
@@ -20,6 +21,14 @@ namespace dae
 		float Normalize();
 		Vector3 Normalized() const;
 
+		//Normalizes with the inverse square root of the given accuracy instead of a square root and 3 divisions
+		template<MathAccuracy Accuracy>
+		Vector3 Normalized() const
+		{
+			const float inverseMagnitude{ InverseSqrt<Accuracy>(x * x + y * y + z * z) };
+			return { x * inverseMagnitude, y * inverseMagnitude, z * inverseMagnitude };
+		}
+
 		static float Dot(const Vector3& v1, const Vector3& v2);
 		static Vector3 Cross(const Vector3& v1, const Vector3& v2);
 		static Vector3 Project(const Vector3& v1, const Vector3& v2);
@@ -6,43 +6,325 @@
 
 //Standard includes
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
+#include "Utils.h"
+#include "Profiler.h"
 
 using namespace dae;
 
 void ShutDown(SDL_Window* pWindow)
 {
-	SDL_DestroyWindow(pWindow);
+	if (pWindow)
+		SDL_DestroyWindow(pWindow);
 	SDL_Quit();
 }
 
-int main(int argc, char* args[])
+//Returns true when there was a trace to write and it could not be written
+bool WriteTrace([[maybe_unused]] const std::string& traceFile)
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+#if defined(ENABLE_PROFILER)
+	if (traceFile.empty() || !Profiler::ExportChromeTrace(traceFile.c_str()))
+		return false;
 
-	//Create window + surfaces
-	SDL_Init(SDL_INIT_VIDEO);
+	std::cout << "Could not write " << traceFile << std::endl;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void PrintUsage()
+{
+	std::cout << "Usage: Rasterizer [options]\n"
+		<< "  --headless                  render offscreen, no window or display needed\n"
+		<< "  --frames <count>            render this many frames at a fixed time step and exit\n"
+		<< "  --output <prefix>           save the frames as <prefix>0000.bmp, <prefix>0001.bmp, ... instead of discarding them\n"
+		<< "  --width <pixels>            (default 640)\n"
+		<< "  --height <pixels>           (default 480)\n"
+		<< "  --benchmark <camera path>   replay the keyframes of the file and report the frame times as json\n"
+		<< "  --timestep <seconds>        time between the frames of a batch or benchmark (default 1/60)\n"
+		<< "  --warmup <count>            frames a benchmark renders before it starts measuring (default 10)\n"
+		<< "  --json <file>               write the benchmark report to a file instead of the console\n"
+		<< "  --visibility-buffer         shade the opaque meshes from a visibility buffer, separates raster and shade times\n"
+		<< "  --trace <file>              write the profiler zones and counters as a chrome://tracing json file on exit\n"
+		<< "  --texture-layout-benchmark  compare the texture layouts and exit\n";
+}
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
+//min, avg, p50, p95, p99 and max in milliseconds as a json object, the percentiles use the nearest rank
+std::string SummarizeTimes(std::vector<double> times)
+{
+	std::sort(times.begin(), times.end());
+	const auto percentile{ [&](double percentage)
+		{
+			const size_t rank{ static_cast<size_t>(std::ceil(percentage / 100.0 * times.size())) };
+			return times[std::max(rank, size_t{ 1 }) - 1];
+		} };
+
+	std::ostringstream summary{};
+	summary << std::fixed << std::setprecision(3)
+		<< "{ \"min\": " << times.front()
+		<< ", \"avg\": " << std::accumulate(times.begin(), times.end(), 0.0) / times.size()
+		<< ", \"p50\": " << percentile(50.0)
+		<< ", \"p95\": " << percentile(95.0)
+		<< ", \"p99\": " << percentile(99.0)
+		<< ", \"max\": " << times.back() << " }";
+	return summary.str();
+}
+
+//Replays the camera path at a fixed time step, so every run renders exactly the same frames and only the timings differ
+int RunBenchmark(Renderer* pRenderer, const std::string& cameraPathFile, int amountOfFrames, int amountOfWarmupFrames, float timeStep, const std::string& jsonFile, int width, int height)
+{
+	std::vector<CameraKeyframe> keyframes{};
+	if (!Utils::ParseCameraPath(cameraPathFile, keyframes))
+	{
+		std::cout << "Could not read the camera path " << cameraPathFile << std::endl;
+		return 1;
+	}
 
-	SDL_Window* pWindow = SDL_CreateWindow(
-		"Rasterizer - W6 DEMO",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+	std::vector<double> frameTimes{};
+	std::vector<double> clearTimes{};
+	std::vector<double> vertexTimes{};
+	std::vector<double> rasterTimes{};
+	std::vector<double> shadeTimes{};
+	std::vector<double> presentTimes{};
+	double hiZRejectedBlocks{};
+
+	//the warmup frames replay the start of the path, so the caches and the thread pool are warm when the measured run begins
+	for (int frame{ -amountOfWarmupFrames }; frame < amountOfFrames; ++frame)
+	{
+		pRenderer->ApplyCameraKeyframe(Utils::SampleCameraPath(keyframes, std::max(frame, 0) * timeStep));
+
+		const auto frameStart{ std::chrono::steady_clock::now() };
+		pRenderer->Render();
+		const std::chrono::duration<double, std::milli> frameDuration{ std::chrono::steady_clock::now() - frameStart };
+
+		if (frame < 0)
+			continue;
+
+		const Renderer::FrameStatistics& statistics{ pRenderer->GetFrameStatistics() };
+		frameTimes.push_back(frameDuration.count());
+		clearTimes.push_back(statistics.clear);
+		vertexTimes.push_back(statistics.vertex);
+		rasterTimes.push_back(statistics.raster);
+		shadeTimes.push_back(statistics.shade);
+		presentTimes.push_back(statistics.present);
+		hiZRejectedBlocks += statistics.hiZRejectedBlocks;
+	}
+
+	std::ostringstream report{};
+	report << "{\n"
+		<< "  \"cameraPath\": \"" << cameraPathFile << "\",\n"
+		<< "  \"width\": " << width << ",\n"
+		<< "  \"height\": " << height << ",\n"
+		<< "  \"frames\": " << amountOfFrames << ",\n"
+		<< "  \"warmupFrames\": " << amountOfWarmupFrames << ",\n"
+		<< "  \"timeStep\": " << timeStep << ",\n"
+		<< "  \"frameTimeMs\": " << SummarizeTimes(frameTimes) << ",\n"
+		<< "  \"stageTimeMs\": {\n"
+		<< "    \"clear\": " << SummarizeTimes(clearTimes) << ",\n"
+		<< "    \"vertex\": " << SummarizeTimes(vertexTimes) << ",\n"
+		<< "    \"raster\": " << SummarizeTimes(rasterTimes) << ",\n"
+		<< "    \"shade\": " << SummarizeTimes(shadeTimes) << ",\n"
+		<< "    \"present\": " << SummarizeTimes(presentTimes) << "\n"
+		<< "  },\n"
+		<< "  \"hiZRejectedBlocksPerFrame\": " << hiZRejectedBlocks / amountOfFrames << "\n"
+		<< "}\n";
+
+	if (jsonFile.empty())
+	{
+		std::cout << report.str();
+		return 0;
+	}
+
+	std::ofstream file{ jsonFile };
+	file << report.str();
+	if (!file)
+	{
+		std::cout << "Could not write " << jsonFile << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+//Renders the frames as fast as possible, the scene advances a fixed time step per frame so every run renders the same images
+int RunBatch(Renderer* pRenderer, Timer* pTimer, int amountOfFrames, float timeStep, const std::string& outputPrefix)
+{
+	pTimer->SetFixedTimeStep(timeStep);
+	pTimer->Start();
+
+	const auto startTime{ std::chrono::steady_clock::now() };
+	for (int frame{}; frame < amountOfFrames; ++frame)
+	{
+		pTimer->Update();
+		pRenderer->Update(pTimer);
+		pRenderer->Render();
+
+		if (!outputPrefix.empty())
+		{
+			std::ostringstream filePath{};
+			filePath << outputPrefix << std::setw(4) << std::setfill('0') << frame << ".bmp";
+			if (pRenderer->SaveBufferToImage(filePath.str().c_str()))
+			{
+				std::cout << "Could not save " << filePath.str() << std::endl;
+				return 1;
+			}
+		}
+	}
+	const std::chrono::duration<double, std::milli> totalTime{ std::chrono::steady_clock::now() - startTime };
+	pTimer->Stop();
+
+	std::cout << "Rendered " << amountOfFrames << " frames in " << totalTime.count() << " ms, "
+		<< totalTime.count() / amountOfFrames << " ms per frame" << std::endl;
+	return 0;
+}
+
+int main(int argc, char* args[])
+{
+	//Command line options
+	bool runTextureLayoutBenchmark{ false };
+	bool isHeadless{ false };
+	bool useVisibilityBuffer{ false };
+	int amountOfFrames{}; //0 runs the interactive loop
+	std::string outputPrefix{}; //empty discards the frames of a batch
+	int width{ 640 };
+	int height{ 480 };
+	std::string cameraPathFile{}; //empty when not benchmarking
+	float timeStep{ 1.f / 60.f };
+	int amountOfWarmupFrames{ 10 };
+	std::string jsonFile{};
+	std::string traceFile{};
+	for (int index{ 1 }; index < argc; ++index)
+	{
+		const std::string option{ args[index] };
+		const bool hasValue{ index + 1 < argc };
+
+		if (option == "--texture-layout-benchmark")
+		{
+			runTextureLayoutBenchmark = true;
+		}
+		else if (option == "--headless")
+		{
+			isHeadless = true;
+		}
+		else if (option == "--visibility-buffer")
+		{
+			useVisibilityBuffer = true;
+		}
+		else if (option == "--frames" && hasValue)
+		{
+			amountOfFrames = std::atoi(args[++index]);
+		}
+		else if (option == "--output" && hasValue)
+		{
+			outputPrefix = args[++index];
+		}
+		else if (option == "--width" && hasValue)
+		{
+			width = std::atoi(args[++index]);
+		}
+		else if (option == "--height" && hasValue)
+		{
+			height = std::atoi(args[++index]);
+		}
+		else if (option == "--benchmark" && hasValue)
+		{
+			cameraPathFile = args[++index];
+		}
+		else if (option == "--timestep" && hasValue)
+		{
+			timeStep = static_cast<float>(std::atof(args[++index]));
+		}
+		else if (option == "--warmup" && hasValue)
+		{
+			amountOfWarmupFrames = std::atoi(args[++index]);
+		}
+		else if (option == "--json" && hasValue)
+		{
+			jsonFile = args[++index];
+		}
+		else if (option == "--trace" && hasValue)
+		{
+#if defined(ENABLE_PROFILER)
+			traceFile = args[++index];
+#else
+			std::cout << "--trace needs the profiler, uncomment ENABLE_PROFILER in Profiler.h" << std::endl;
+			return 1;
+#endif
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
 
-	if (!pWindow)
+	if (width <= 0 || height <= 0 || amountOfFrames < 0 || timeStep <= 0.f || amountOfWarmupFrames < 0)
+	{
+		PrintUsage();
 		return 1;
+	}
+
+	const bool runBenchmark{ !cameraPathFile.empty() };
+
+	//a benchmark covers 10 seconds of its path unless told otherwise, at least one frame even when a time step is longer than that,
+	//without a window there is nothing to interact with, so a headless run is always a batch
+	if (runBenchmark && amountOfFrames == 0)
+		amountOfFrames = std::max(1, static_cast<int>(std::ceil(10.f / timeStep)));
+	if (isHeadless && amountOfFrames == 0)
+		amountOfFrames = 1;
+
+	//Create window + surfaces
+	SDL_Window* pWindow{};
+	if (!isHeadless)
+	{
+		SDL_Init(SDL_INIT_VIDEO);
+
+		pWindow = SDL_CreateWindow(
+			"Rasterizer - W6 DEMO",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			width, height, 0);
+
+		if (!pWindow)
+			return 1;
+	}
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = isHeadless ? new Renderer(width, height) : new Renderer(pWindow);
+	pRenderer->SetUseVisibilityBuffer(useVisibilityBuffer);
+
+	if (runTextureLayoutBenchmark || amountOfFrames > 0)
+	{
+		int result{};
+		if (runTextureLayoutBenchmark)
+			pRenderer->RunTextureLayoutBenchmark();
+		else if (runBenchmark)
+			result = RunBenchmark(pRenderer, cameraPathFile, amountOfFrames, amountOfWarmupFrames, timeStep, jsonFile, width, height);
+		else
+			result = RunBatch(pRenderer, pTimer, amountOfFrames, timeStep, outputPrefix);
+
+		if (WriteTrace(traceFile))
+			result = 1;
+
+		delete pRenderer;
+		delete pTimer;
+		ShutDown(pWindow);
+		return result;
+	}
 
 	//Start loop
 	pTimer->Start();
@@ -83,6 +365,31 @@ int main(int argc, char* args[])
 				{
 					pRenderer->ChangeRenderMode();
 				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+				{
+					pRenderer->ChangeRasterBackend();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+				{
+					pRenderer->SetUseVisibilityBuffer(!pRenderer->GetUseVisibilityBuffer());
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+				{
+					pRenderer->ChangeFilterMode();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+				{
+					pRenderer->ChangeTextureLayout();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
+				{
+					pRenderer->ChangeShadingAccuracy();
+				}
 				break;
 			}
 		}
@@ -100,6 +407,15 @@ int main(int argc, char* args[])
 		{
 			printTimer = 0.f;
 			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+#if defined(ENABLE_PROFILER)
+			std::cout << "triangles: " << Profiler::GetFrameCounter(ProfileCounter::trianglesSubmitted) << " submitted, "
+				<< Profiler::GetFrameCounter(ProfileCounter::trianglesCulled) << " culled, "
+				<< Profiler::GetFrameCounter(ProfileCounter::trianglesClipped) << " clipped, fragments: "
+				<< Profiler::GetFrameCounter(ProfileCounter::fragmentsTested) << " tested, "
+				<< Profiler::GetFrameCounter(ProfileCounter::fragmentsPassed) << " passed, "
+				<< Profiler::GetFrameCounter(ProfileCounter::fragmentsShaded) << " shaded, Hi-Z rejected blocks: "
+				<< Profiler::GetFrameCounter(ProfileCounter::hiZRejectedBlocks) << std::endl;
+#endif
 		}
 
 		//Save screenshot after full render
@@ -114,10 +430,12 @@ int main(int argc, char* args[])
 	}
 	pTimer->Stop();
 
+	const int result{ WriteTrace(traceFile) ? 1 : 0 };
+
 	//Shutdown "framework"
 	delete pRenderer;
 	delete pTimer;
 
 	ShutDown(pWindow);
-	return 0;
+	return result;
 }
\ No newline at end of file
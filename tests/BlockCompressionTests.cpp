@@ -0,0 +1,201 @@
+#include <cstdio>
+#include "BlockCompression.h"
+
+using namespace dae;
+
+//Decodes hand built bc1, bc3 and bc5 blocks and compares every texel with the value the D3D10 formats define for it,
+//the expected texels are worked out by hand, returns the amount of blocks that don't match
+namespace
+{
+	int g_AmountOfFailures{};
+
+	constexpr uint32_t MakeTexel(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return r | g << 8 | b << 16 | a << 24;
+	}
+
+	void CheckBlock(const char* pName, TextureFormat format, const uint8_t* pBlock, const uint32_t expectedTexels[16])
+	{
+		uint32_t texels[16]{};
+		DecodeBlock(format, pBlock, texels);
+
+		int amountOfWrongTexels{};
+		for (int index{}; index < 16; ++index)
+		{
+			if (texels[index] != expectedTexels[index])
+			{
+				std::printf("  texel %d: 0x%08x instead of 0x%08x\n", index, texels[index], expectedTexels[index]);
+				++amountOfWrongTexels;
+			}
+		}
+
+		std::printf("%s %s\n", amountOfWrongTexels == 0 ? "passed" : "FAILED", pName);
+		if (amountOfWrongTexels > 0)
+			++g_AmountOfFailures;
+	}
+
+	//the 2 bit indices of a color block, texel 0 in the lowest bits
+	void WriteColorIndices(const int indices[16], uint8_t* pBlock)
+	{
+		uint32_t bits{};
+		for (int index{}; index < 16; ++index)
+		{
+			bits |= static_cast<uint32_t>(indices[index]) << (2 * index);
+		}
+		for (int byte{}; byte < 4; ++byte)
+		{
+			pBlock[byte] = static_cast<uint8_t>(bits >> (8 * byte));
+		}
+	}
+
+	//the 3 bit indices of a channel block, texel 0 in the lowest bits
+	void WriteChannelIndices(const int indices[16], uint8_t* pBlock)
+	{
+		uint64_t bits{};
+		for (int index{}; index < 16; ++index)
+		{
+			bits |= static_cast<uint64_t>(indices[index]) << (3 * index);
+		}
+		for (int byte{}; byte < 6; ++byte)
+		{
+			pBlock[byte] = static_cast<uint8_t>(bits >> (8 * byte));
+		}
+	}
+
+	//every row reads the 4 colors of the palette in order
+	constexpr int g_ColorIndices[16]{ 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 };
+	//the 8 values of the palette in order, twice
+	constexpr int g_ChannelIndices[16]{ 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+	void TestBC1()
+	{
+		//red 0xf800 > blue 0x001f: 4 opaque colors, the middle ones at 1/3 and 2/3
+		{
+			uint8_t block[8]{ 0x00, 0xf8, 0x1f, 0x00 };
+			WriteColorIndices(g_ColorIndices, block + 4);
+
+			const uint32_t row[4]{ MakeTexel(255, 0, 0, 255), MakeTexel(0, 0, 255, 255), MakeTexel(170, 0, 85, 255), MakeTexel(85, 0, 170, 255) };
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = row[index & 3];
+			}
+			CheckBlock("bc1 4 colors", TextureFormat::bc1, block, expected);
+		}
+
+		//blue 0x001f <= red 0xf800: 3 colors, the middle one halfway, and transparent black
+		{
+			uint8_t block[8]{ 0x1f, 0x00, 0x00, 0xf8 };
+			WriteColorIndices(g_ColorIndices, block + 4);
+
+			const uint32_t row[4]{ MakeTexel(0, 0, 255, 255), MakeTexel(255, 0, 0, 255), MakeTexel(128, 0, 128, 255), MakeTexel(0, 0, 0, 0) };
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = row[index & 3];
+			}
+			CheckBlock("bc1 3 colors and transparent black", TextureFormat::bc1, block, expected);
+		}
+
+		//0x8410 is 16, 32, 16 in 5:6:5, the top bits are repeated in the bottom ones
+		{
+			const uint8_t block[8]{ 0x10, 0x84, 0x10, 0x84 };
+
+			uint32_t expected[16]{};
+			for (uint32_t& texel : expected)
+			{
+				texel = MakeTexel(132, 130, 132, 255);
+			}
+			CheckBlock("bc1 5:6:5 expansion", TextureFormat::bc1, block, expected);
+		}
+	}
+
+	void TestBC3()
+	{
+		//alpha 255 > 0: 6 values at 1/7 steps. The color part always has 4 colors, even when color0 <= color1
+		{
+			uint8_t block[16]{ 255, 0 };
+			WriteChannelIndices(g_ChannelIndices, block + 2);
+			block[8] = 0x1f;
+			block[9] = 0x00;
+			block[10] = 0x00;
+			block[11] = 0xf8;
+			WriteColorIndices(g_ColorIndices, block + 12);
+
+			const uint32_t alphas[8]{ 255, 0, 219, 182, 146, 109, 73, 36 };
+			const uint32_t colors[4]{ MakeTexel(0, 0, 255, 0), MakeTexel(255, 0, 0, 0), MakeTexel(85, 0, 170, 0), MakeTexel(170, 0, 85, 0) };
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = colors[index & 3] | alphas[index & 7] << 24;
+			}
+			CheckBlock("bc3 8 alphas", TextureFormat::bc3, block, expected);
+		}
+
+		//alpha 0 <= 255: 4 values at 1/5 steps, then 0 and 255
+		{
+			uint8_t block[16]{ 0, 255 };
+			WriteChannelIndices(g_ChannelIndices, block + 2);
+			block[8] = 0x00;
+			block[9] = 0xf8;
+			block[10] = 0x00;
+			block[11] = 0xf8;
+
+			const uint32_t alphas[8]{ 0, 255, 51, 102, 153, 204, 0, 255 };
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = MakeTexel(255, 0, 0, alphas[index & 7]);
+			}
+			CheckBlock("bc3 6 alphas with 0 and 255", TextureFormat::bc3, block, expected);
+		}
+	}
+
+	void TestBC5()
+	{
+		//x in the first channel block, y in the second, z is rebuilt so the normal has unit length
+		{
+			uint8_t block[16]{ 255, 128 };
+			const int xIndices[16]{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 };
+			WriteChannelIndices(xIndices, block + 2);
+			block[8] = 128;
+			block[9] = 128;
+
+			//x = 1 leaves no room for z, so it is 0 and stored as 128. x = y = 128 is almost straight up
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = index % 2 == 0 ? MakeTexel(255, 128, 128, 255) : MakeTexel(128, 128, 255, 255);
+			}
+			CheckBlock("bc5 normal", TextureFormat::bc5, block, expected);
+		}
+
+		//both channels use the 8 value palette of the channel blocks of bc3
+		{
+			uint8_t block[16]{ 255, 0 };
+			WriteChannelIndices(g_ChannelIndices, block + 2);
+			block[8] = 255;
+			block[9] = 0;
+			const int yIndices[16]{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+			WriteChannelIndices(yIndices, block + 10);
+
+			//y = 0 is -1, so z is 0 for every x
+			const uint32_t xs[8]{ 255, 0, 219, 182, 146, 109, 73, 36 };
+			uint32_t expected[16]{};
+			for (int index{}; index < 16; ++index)
+			{
+				expected[index] = MakeTexel(xs[index & 7], 0, 128, 255);
+			}
+			CheckBlock("bc5 8 values", TextureFormat::bc5, block, expected);
+		}
+	}
+}
+
+int main()
+{
+	TestBC1();
+	TestBC3();
+	TestBC5();
+
+	return g_AmountOfFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include <cmath>
+#include <cstdio>
+#include "MathHelpers.h"
+
+using namespace dae;
+
+//Sweeps the fast math functions of every accuracy against the double precision standard library
+//and checks the error bounds documented in MathHelpers.h, returns the amount of bounds that don't hold
+namespace
+{
+	int g_AmountOfFailures{};
+
+	void CheckBound(const char* pName, double maximumError, double bound)
+	{
+		const bool isWithinBound{ maximumError < bound };
+		std::printf("%s %s: maximum error %g, bound %g\n", isWithinBound ? "passed" : "FAILED", pName, maximumError, bound);
+		if (!isWithinBound)
+			++g_AmountOfFailures;
+	}
+
+	//every exponent of the normal floats with 4096 mantissas each, plus the floats right around 1 where log2 crosses 0
+	template<typename Function>
+	void ForEachPositiveFloat(Function function)
+	{
+		for (int exponent{ -126 }; exponent <= 127; ++exponent)
+		{
+			for (int mantissaIndex{}; mantissaIndex < 4096; ++mantissaIndex)
+			{
+				function(std::ldexp(1.f + mantissaIndex / 4096.f, exponent));
+			}
+		}
+
+		float below{ 1.f };
+		float above{ 1.f };
+		for (int step{}; step < 4096; ++step)
+		{
+			below = std::nextafter(below, 0.f);
+			above = std::nextafter(above, 2.f);
+			function(below);
+			function(above);
+		}
+	}
+
+	template<MathAccuracy Accuracy>
+	void TestAccuracy(const char* pAccuracyName, double relativeBound, double log2Bound, bool isLog2BoundAbsolute, double powBound)
+	{
+		char name[64]{};
+
+		double log2Error{};
+		double inverseSqrtError{};
+		ForEachPositiveFloat([&](float x)
+			{
+				const double log2{ std::log2(static_cast<double>(x)) };
+				const double error{ std::abs(Log2<Accuracy>(x) - log2) };
+				if (isLog2BoundAbsolute)
+					log2Error = std::max(log2Error, error);
+				else if (log2 != 0.0)
+					log2Error = std::max(log2Error, error / std::abs(log2));
+
+				const double inverseSqrt{ 1.0 / std::sqrt(static_cast<double>(x)) };
+				inverseSqrtError = std::max(inverseSqrtError, std::abs(InverseSqrt<Accuracy>(x) - inverseSqrt) / inverseSqrt);
+			});
+
+		//the absolute error of the exact log2 is the rounding of results up to 127, the float itself can't be closer
+		std::snprintf(name, sizeof(name), "Log2<%s> %s", pAccuracyName, isLog2BoundAbsolute ? "absolute" : "relative");
+		CheckBound(name, log2Error, log2Bound);
+		std::snprintf(name, sizeof(name), "InverseSqrt<%s> relative", pAccuracyName);
+		CheckBound(name, inverseSqrtError, relativeBound);
+
+		double exp2Error{};
+		for (int index{}; index <= 253 * 4096; ++index)
+		{
+			const float x{ -126.f + index / 4096.f };
+			const double exp2{ std::exp2(static_cast<double>(x)) };
+			exp2Error = std::max(exp2Error, std::abs(Exp2<Accuracy>(x) - exp2) / exp2);
+		}
+		std::snprintf(name, sizeof(name), "Exp2<%s> relative", pAccuracyName);
+		CheckBound(name, exp2Error, relativeBound);
+
+		//the range the specular power uses, the error is absolute because small powers flush to 0
+		double powError{};
+		for (int baseIndex{}; baseIndex <= 4096; ++baseIndex)
+		{
+			for (int exponentIndex{}; exponentIndex <= 512; ++exponentIndex)
+			{
+				const float base{ baseIndex / 4096.f };
+				const float exponent{ exponentIndex / 16.f };
+				const double power{ std::pow(static_cast<double>(base), static_cast<double>(exponent)) };
+				powError = std::max(powError, std::abs(Pow<Accuracy>(base, exponent) - power));
+			}
+		}
+		std::snprintf(name, sizeof(name), "Pow<%s> absolute", pAccuracyName);
+		CheckBound(name, powError, powBound);
+	}
+
+	//the parabola of the approximate log2 goes through both ends of the mantissa, so log2(1) is 0 and not just close to it
+	void TestApproximateLog2OfPowersOf2()
+	{
+		double error{};
+		for (int exponent{ -126 }; exponent <= 127; ++exponent)
+		{
+			error = std::max(error, std::abs(static_cast<double>(Log2<MathAccuracy::approximate>(std::ldexp(1.f, exponent))) - exponent));
+		}
+		CheckBound("Log2<approximate> of powers of 2 absolute", error, 1e-30);
+	}
+
+	void TestSpecularLookupTable()
+	{
+		constexpr float shininess{ 25.f };
+		const SpecularLookupTable table{ shininess };
+
+		double quantizedError{};
+		double filteredError{};
+		for (int cosineIndex{ 256 }; cosineIndex <= 4096; ++cosineIndex)
+		{
+			const float cosine{ cosineIndex / 4096.f };
+			for (int glossinessIndex{}; glossinessIndex <= 1020; ++glossinessIndex)
+			{
+				const float glossiness{ glossinessIndex / 1020.f };
+				const double power{ std::pow(static_cast<double>(cosine), static_cast<double>(shininess * glossiness)) };
+				const double error{ std::abs(table.Lookup(cosine, glossiness) - power) };
+
+				//every 4th glossiness is a value of an 8 bit channel
+				if (glossinessIndex % 4 == 0)
+					quantizedError = std::max(quantizedError, error);
+				filteredError = std::max(filteredError, error);
+			}
+		}
+
+		CheckBound("SpecularLookupTable 8 bit glossiness absolute", quantizedError, 4e-3);
+		CheckBound("SpecularLookupTable filtered glossiness absolute", filteredError, 1e-2);
+	}
+}
+
+int main()
+{
+	TestAccuracy<MathAccuracy::exact>("exact", 1e-6, 1e-5, true, 1e-6);
+	TestAccuracy<MathAccuracy::fast>("fast", 1e-5, 1e-5, false, 1e-5);
+	TestAccuracy<MathAccuracy::approximate>("approximate", 1e-2, 8e-3, true, 4e-2);
+	TestApproximateLog2OfPowersOf2();
+	TestSpecularLookupTable();
+
+	return g_AmountOfFailures == 0 ? 0 : 1;
+}